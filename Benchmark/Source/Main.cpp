@@ -0,0 +1,663 @@
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/EQoonEngine.h"
+
+/*
+    Headless processBlock benchmark. Builds EQoonAudioProcessor without an editor, sweeps
+    the configurations below and prints one JSON document with the timings of each.
+
+    Usage: EQoonBenchmark [--quick | --cramping | --routing | --dynamics | --idle]
+                          [--seconds <audio seconds per configuration>]
+                          [--output <file>]
+           EQoonBenchmark --engines [--seconds <audio seconds per configuration>] [--output <file>]
+           EQoonBenchmark --rt-check
+
+    nsPerSample is wall time per sample frame (all channels of one sample). cyclesPerSample
+    scales it by the nominal CPU clock, so it is only comparable on the same machine.
+    stageNsPerSample splits it up as the processor's load meter does (ProcessLoadMeter).
+
+    maxBandErrorDb is the largest deviation of any active peak or shelf band from its
+    analog prototype between 20 Hz and 20 kHz (or 0.45 fs), so the cost of each way of
+    fixing the cramping near Nyquist can be weighed against what it buys. It measures
+    the band designs only; the oversampling filters' own ripple isn't included.
+
+    --engines times EQoonEngine instead: many stereo streams, each with its own engine,
+    processed in turn in 64-sample blocks the way a server would interleave them, with
+    each engine's memory footprint.
+*/
+
+// How the peak and shelf bands are kept from cramping near Nyquist.
+struct CrampingFix
+{
+    const char* name;
+    BandDesign design;
+    int oversamplingOrder;
+    OversamplingFilter filter;
+};
+
+static const CrampingFix noCrampingFix { "None", BandDesign::bilinear, 0, OversamplingFilter::minimumLatency };
+
+static const juce::Array<CrampingFix> allCrampingFixes
+{
+    noCrampingFix,
+    { "Matched", BandDesign::matched, 0, OversamplingFilter::minimumLatency },
+    { "2x IIR", BandDesign::bilinear, 1, OversamplingFilter::minimumLatency },
+    { "4x IIR", BandDesign::bilinear, 2, OversamplingFilter::minimumLatency },
+    { "8x IIR", BandDesign::bilinear, 3, OversamplingFilter::minimumLatency },
+    { "2x FIR", BandDesign::bilinear, 1, OversamplingFilter::linearPhase },
+    { "4x FIR", BandDesign::bilinear, 2, OversamplingFilter::linearPhase },
+    { "8x FIR", BandDesign::bilinear, 3, OversamplingFilter::linearPhase }
+};
+
+// Per-band routing, in ChainPositions order. Routings only apply to stereo layouts.
+struct RoutingPreset
+{
+    const char* name;
+    std::array<ChannelRouting, ChainPositions::HighCut + 1> bands;
+};
+
+static const RoutingPreset stereoRouting { "Stereo", {} };
+
+static const juce::Array<RoutingPreset> allRoutings
+{
+    stereoRouting,
+    // Side-only low cut and mid/side bands: encoded and decoded while interleaving.
+    { "Mid/Side", { ChannelRouting::side, ChannelRouting::mid, ChannelRouting::mid, ChannelRouting::side,
+                    ChannelRouting::stereo, ChannelRouting::side, ChannelRouting::stereo } },
+    { "Left/Right", { ChannelRouting::stereo, ChannelRouting::left, ChannelRouting::left, ChannelRouting::right,
+                      ChannelRouting::right, ChannelRouting::stereo, ChannelRouting::stereo } },
+    // Switches representation three times, each costing a conversion pass.
+    { "Mixed", { ChannelRouting::stereo, ChannelRouting::left, ChannelRouting::mid, ChannelRouting::right,
+                 ChannelRouting::side, ChannelRouting::stereo, ChannelRouting::stereo } }
+};
+
+// Dynamics on every active gain band, detecting on the main input or on a stereo
+// sidechain fed the same noise.
+struct DynamicsPreset
+{
+    const char* name;
+    bool enabled;
+    DetectorSource source;
+};
+
+static const DynamicsPreset noDynamics { "None", false, DetectorSource::mainInput };
+
+static const juce::Array<DynamicsPreset> allDynamics
+{
+    noDynamics,
+    { "Main Input", true, DetectorSource::mainInput },
+    { "Sidechain", true, DetectorSource::sidechain }
+};
+
+// What the processor is fed. Partly silent feeds the first two channels only, like a
+// 7.1.4 bed with nothing in its surrounds and heights, so the other channel groups idle.
+enum class InputSignal
+{
+    noise,
+    silence,
+    partlySilent
+};
+
+static const char* getTopologyName(FilterTopology topology)
+{
+    return topology == FilterTopology::svf ? "SVF" : topology == FilterTopology::parallel ? "Parallel" : "Biquad";
+}
+
+static const char* getInputSignalName(InputSignal input)
+{
+    return input == InputSignal::silence ? "Silence" : input == InputSignal::partlySilent ? "Partly Silent" : "Noise";
+}
+
+struct Configuration
+{
+    double sampleRate;
+    int blockSize;
+    int numChannels;
+    Slope slope;
+    int activeBands;
+    FilterTopology topology;
+    CrampingFix crampingFix = noCrampingFix;
+    bool parallelChannels = false;
+    RoutingPreset routing = stereoRouting;
+    DynamicsPreset dynamics = noDynamics;
+    InputSignal input = InputSignal::noise;
+};
+
+struct Sweep
+{
+    juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    juce::Array<int> channelCounts { 1, 2, 12, 16 }; // Mono, stereo, 7.1.4, third order ambisonics
+    juce::Array<Slope> slopes { Slope_12, Slope_24, Slope_36, Slope_48 };
+    juce::Array<int> activeBands { 0, 1, 2, 3, 4, 5 };
+    juce::Array<FilterTopology> topologies { FilterTopology::biquad, FilterTopology::svf, FilterTopology::parallel };
+    juce::Array<CrampingFix> crampingFixes { noCrampingFix };
+    juce::Array<bool> parallelModes { false, true }; // Only for layouts with several channel groups
+    juce::Array<RoutingPreset> routings { stereoRouting };
+    juce::Array<DynamicsPreset> dynamicsPresets { noDynamics };
+    juce::Array<InputSignal> inputs { InputSignal::noise }; // Partly silent needs more than two channels
+};
+
+static Sweep makeQuickSweep()
+{
+    Sweep sweep;
+    sweep.sampleRates = { 48000.0 };
+    sweep.blockSizes = { 64, 512 };
+    sweep.channelCounts = { 2, 12 };
+    sweep.slopes = { Slope_12, Slope_48 };
+    sweep.activeBands = { 0, 5 };
+    sweep.crampingFixes = { allCrampingFixes[0], allCrampingFixes[1], allCrampingFixes[2], allCrampingFixes[5] };
+    return sweep;
+}
+
+// Every cramping fix at the rates where cramping matters, with all bands on.
+static Sweep makeCrampingSweep()
+{
+    Sweep sweep;
+    sweep.sampleRates = { 44100.0, 48000.0, 96000.0 };
+    sweep.blockSizes = { 64, 512 };
+    sweep.channelCounts = { 2 };
+    sweep.slopes = { Slope_12 };
+    sweep.activeBands = { 5 };
+    sweep.crampingFixes = allCrampingFixes;
+    sweep.parallelModes = { false };
+    return sweep;
+}
+
+// Every routing on a stereo bus, against the plain stereo cost.
+static Sweep makeRoutingSweep()
+{
+    Sweep sweep;
+    sweep.sampleRates = { 48000.0 };
+    sweep.blockSizes = { 64, 512 };
+    sweep.channelCounts = { 2 };
+    sweep.slopes = { Slope_12, Slope_48 };
+    sweep.activeBands = { 5 };
+    sweep.parallelModes = { false };
+    sweep.routings = allRoutings;
+    return sweep;
+}
+
+// The dynamic bands, which redesign on every control tick, against static ones.
+static Sweep makeDynamicsSweep()
+{
+    Sweep sweep;
+    sweep.sampleRates = { 48000.0 };
+    sweep.blockSizes = { 64, 512 };
+    sweep.channelCounts = { 2 };
+    sweep.slopes = { Slope_12 };
+    sweep.activeBands = { 1, 5 };
+    sweep.parallelModes = { false };
+    sweep.dynamicsPresets = allDynamics;
+    return sweep;
+}
+
+// Silent input, which skips the filters once the tail has passed, against noise.
+static Sweep makeIdleSweep()
+{
+    Sweep sweep;
+    sweep.sampleRates = { 48000.0 };
+    sweep.blockSizes = { 64, 512 };
+    sweep.channelCounts = { 2, 12 };
+    sweep.slopes = { Slope_48 };
+    sweep.activeBands = { 5 };
+    sweep.parallelModes = { false };
+    sweep.inputs = { InputSignal::noise, InputSignal::silence, InputSignal::partlySilent };
+    return sweep;
+}
+
+// Bell and shelf bands in the order they are switched on. A band at 0 dB is an identity
+// section and costs nothing; both cuts always run. Peak3 and HighShelf sit high enough
+// to cramp at 44.1/48 kHz.
+static const juce::StringArray gainBands { "Peak1", "Peak2", "Peak3", "LowShelf", "HighShelf" };
+static const ChainPositions gainBandPositions[] { Peak1, Peak2, Peak3, LowShelf, HighShelf };
+
+static void setParameter(EQoonAudioProcessor& processor, const juce::String& parameterID, float value)
+{
+    auto* parameter = processor.apvts.getParameter(parameterID);
+    jassert(parameter != nullptr);
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+static void applyConfiguration(EQoonAudioProcessor& processor, const Configuration& configuration)
+{
+    setParameter(processor, "LowCut Freq", 80.f);
+    setParameter(processor, "LowCut Slope", (float) configuration.slope);
+    setParameter(processor, "HighCut Freq", 12000.f);
+    setParameter(processor, "HighCut Slope", (float) configuration.slope);
+    setParameter(processor, "Filter Topology", (float) configuration.topology);
+    setParameter(processor, "Peak3 Freq", 12000.f);
+    setParameter(processor, "HighShelf Freq", 10000.f);
+    setParameter(processor, "Band Design", (float) configuration.crampingFix.design);
+    setParameter(processor, "Oversampling", (float) configuration.crampingFix.oversamplingOrder);
+    setParameter(processor, "Oversampling Filter", (float) configuration.crampingFix.filter);
+    setParameter(processor, "Parallel Channels", configuration.parallelChannels ? 1.f : 0.f);
+
+    for (size_t band = 0; band < configuration.routing.bands.size(); ++band)
+        setParameter(processor, juce::String(getBandName(static_cast<ChainPositions>(band))) + " Routing",
+                     (float) configuration.routing.bands[band]);
+
+    for (int band = 0; band < gainBands.size(); ++band)
+    {
+        auto active = band < configuration.activeBands;
+        setParameter(processor, gainBands[band] + " Gain", active ? 6.f : 0.f);
+        setParameter(processor, gainBands[band] + " Threshold", -30.f);
+        setParameter(processor, gainBands[band] + " Ratio", active && configuration.dynamics.enabled ? 4.f : 1.f);
+    }
+
+    setParameter(processor, "Dynamics Detector", (float) configuration.dynamics.source);
+
+    auto channelSet = juce::AudioChannelSet::canonicalChannelSet(configuration.numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.inputBuses.add(configuration.dynamics.enabled && configuration.dynamics.source == DetectorSource::sidechain
+                            ? juce::AudioChannelSet::stereo() : juce::AudioChannelSet::disabled());
+    layout.outputBuses.add(channelSet);
+    processor.setBusesLayout(layout);
+}
+
+static double getMaxBandErrorDecibels(const FilterSnapshot& snapshot, int activeBands)
+{
+    constexpr int numFrequencies = 256;
+    auto maxFrequency = juce::jmin(20000.0, 0.45 * snapshot.hostSampleRate);
+    double maxError = 0.0;
+
+    for (int band = 0; band < activeBands; ++band)
+    {
+        auto position = gainBandPositions[band];
+        const auto& section = snapshot.sections[(size_t) getBandSections(position).getStart()];
+
+        for (int i = 0; i < numFrequencies; ++i)
+        {
+            auto frequency = juce::mapToLog10((double) i / (numFrequencies - 1), 20.0, maxFrequency);
+            auto designed = getMagnitudeForFrequency(section, frequency, snapshot.sampleRate);
+            auto prototype = getPrototypeMagnitudeForFrequency(snapshot.settings, position, frequency);
+            maxError = juce::jmax(maxError, std::abs(juce::Decibels::gainToDecibels(designed / prototype, -200.0)));
+        }
+    }
+
+    return maxError;
+}
+
+static juce::var runConfiguration(const Configuration& configuration, double secondsPerConfiguration)
+{
+    EQoonAudioProcessor processor;
+    applyConfiguration(processor, configuration);
+
+    processor.setRateAndBufferSizeDetails(configuration.sampleRate, configuration.blockSize);
+    processor.prepareToPlay(configuration.sampleRate, configuration.blockSize);
+
+    // White noise at -12 dBFS, the same for every configuration. The buffer also carries
+    // the sidechain's channels when it is enabled, fed the same noise.
+    auto numBufferChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+    auto numNoiseChannels = configuration.input == InputSignal::silence      ? 0
+                          : configuration.input == InputSignal::partlySilent ? 2
+                                                                             : numBufferChannels;
+    juce::AudioBuffer<float> buffer(numBufferChannels, configuration.blockSize);
+    juce::AudioBuffer<float> source(numBufferChannels, configuration.blockSize);
+    juce::Random random(0x45516f6f);
+    source.clear();
+    for (int channel = 0; channel < numNoiseChannels; ++channel)
+        for (int i = 0; i < source.getNumSamples(); ++i)
+            source.setSample(channel, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+
+    juce::MidiBuffer midi;
+    auto process = [&]
+    {
+        buffer.makeCopyOf(source, true);
+        processor.processBlock(buffer, midi);
+    };
+
+    auto samplesPerSecond = configuration.sampleRate;
+    auto warmUpBlocks = juce::jmax(16, (int) (0.1 * samplesPerSecond / configuration.blockSize));
+
+    // Silent channels only go idle once the tail has passed.
+    if (configuration.input != InputSignal::noise)
+        warmUpBlocks += (int) std::ceil(processor.getTailLengthSeconds() * samplesPerSecond / configuration.blockSize) + 1;
+    auto measuredBlocks = juce::jmax(64, (int) (secondsPerConfiguration * samplesPerSecond / configuration.blockSize));
+
+    for (int block = 0; block < warmUpBlocks; ++block)
+        process();
+
+    std::vector<double> blockNanoseconds;
+    blockNanoseconds.reserve((size_t) measuredBlocks);
+
+    auto ticksToNanoseconds = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    auto loadBefore = processor.getProcessLoad();
+
+    for (int block = 0; block < measuredBlocks; ++block)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        process();
+        blockNanoseconds.push_back((double) (juce::Time::getHighResolutionTicks() - start) * ticksToNanoseconds);
+    }
+
+    // Where the time went, from the processor's own meter.
+    auto loadAfter = processor.getProcessLoad();
+    auto* stageNanoseconds = new juce::DynamicObject();
+
+    for (int stage = 0; stage < ProcessLoadMeter::numStages; ++stage)
+    {
+        auto seconds = loadAfter.stageSeconds[(size_t) stage] - loadBefore.stageSeconds[(size_t) stage];
+        stageNanoseconds->setProperty(ProcessLoadMeter::getStageName((ProcessLoadMeter::Stage) stage),
+                                      1.0e9 * seconds / ((double) measuredBlocks * configuration.blockSize));
+    }
+
+    auto maxBandErrorDecibels = getMaxBandErrorDecibels(processor.getLatestSnapshot(), configuration.activeBands);
+    auto latencySamples = processor.getLatencySamples();
+    processor.releaseResources();
+
+    auto totalNanoseconds = std::accumulate(blockNanoseconds.begin(), blockNanoseconds.end(), 0.0);
+    auto nanosecondsPerSample = totalNanoseconds / ((double) measuredBlocks * configuration.blockSize);
+    auto cpuMegahertz = juce::SystemStats::getCpuSpeedInMegahertz();
+
+    std::sort(blockNanoseconds.begin(), blockNanoseconds.end());
+    auto p99Index = (size_t) std::ceil(0.99 * (double) blockNanoseconds.size()) - 1;
+    auto blockDurationNanoseconds = 1.0e9 * configuration.blockSize / configuration.sampleRate;
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("sampleRate", configuration.sampleRate);
+    result->setProperty("blockSize", configuration.blockSize);
+    result->setProperty("numChannels", configuration.numChannels);
+    result->setProperty("slopeDbPerOct", 12 * (configuration.slope + 1));
+    result->setProperty("activeBands", configuration.activeBands);
+    result->setProperty("topology", getTopologyName(configuration.topology));
+    result->setProperty("crampingFix", configuration.crampingFix.name);
+    result->setProperty("maxBandErrorDb", maxBandErrorDecibels);
+    result->setProperty("latencySamples", latencySamples);
+    result->setProperty("parallelChannels", configuration.parallelChannels);
+    result->setProperty("routing", configuration.routing.name);
+    result->setProperty("dynamics", configuration.dynamics.name);
+    result->setProperty("input", getInputSignalName(configuration.input));
+    result->setProperty("blocks", measuredBlocks);
+    result->setProperty("nsPerSample", nanosecondsPerSample);
+    result->setProperty("stageNsPerSample", juce::var(stageNanoseconds));
+    result->setProperty("cyclesPerSample", cpuMegahertz > 0 ? juce::var(nanosecondsPerSample * cpuMegahertz * 1.0e-3) : juce::var());
+    result->setProperty("meanBlockNs", totalNanoseconds / measuredBlocks);
+    result->setProperty("p99BlockNs", blockNanoseconds[p99Index]);
+    result->setProperty("maxBlockNs", blockNanoseconds.back());
+    result->setProperty("realtimeFactor", blockDurationNanoseconds * measuredBlocks / totalNanoseconds);
+    return juce::var(result);
+}
+
+//==============================================================================
+// --engines: the headless engine on many concurrent streams.
+
+static ChainSettings makeEngineSettings(FilterTopology topology)
+{
+    ChainSettings settings;
+    settings.lowCutFreq = 30.f;
+    settings.lowCutSlope = Slope_24;
+    settings.highCutFreq = 18000.f;
+    settings.highCutSlope = Slope_24;
+    settings.lowShelfFreq = 120.f;
+    settings.lowShelfGainInDecibels = 3.f;
+    settings.highShelfFreq = 8000.f;
+    settings.highShelfGainInDecibels = -2.f;
+    settings.peakFreq1 = 250.f;
+    settings.peakGainInDecibels1 = -4.f;
+    settings.peakFreq2 = 1200.f;
+    settings.peakGainInDecibels2 = 2.f;
+    settings.peakFreq3 = 4500.f;
+    settings.peakGainInDecibels3 = 3.f;
+    settings.topology = topology;
+    return settings;
+}
+
+static juce::var runEngines(int numStreams, FilterTopology topology, double secondsPerConfiguration)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2, blockSize = 64;
+
+    std::vector<std::unique_ptr<EQoonEngine>> engines;
+    juce::AudioBuffer<float> buffer(numChannels * numStreams, blockSize);
+    juce::Random random(0x45516f6f);
+
+    for (int stream = 0; stream < numStreams; ++stream)
+    {
+        engines.push_back(std::make_unique<EQoonEngine>());
+        engines.back()->prepare(sampleRate, numChannels);
+        engines.back()->setSettings(makeEngineSettings(topology));
+    }
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        for (int i = 0; i < blockSize; ++i)
+            buffer.setSample(channel, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+
+    auto processAll = [&]
+    {
+        for (int stream = 0; stream < numStreams; ++stream)
+            engines[(size_t) stream]->process(buffer.getArrayOfWritePointers() + stream * numChannels, numChannels, blockSize);
+    };
+
+    // The audio seconds are shared out between the streams.
+    auto rounds = juce::jmax(16, (int) (secondsPerConfiguration * sampleRate / blockSize / numStreams));
+
+    for (int round = 0; round < 16; ++round)
+        processAll();
+
+    auto start = juce::Time::getHighResolutionTicks();
+    for (int round = 0; round < rounds; ++round)
+        processAll();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    auto streamSamples = (double) rounds * blockSize * numStreams;
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("streams", numStreams);
+    result->setProperty("numChannels", numChannels);
+    result->setProperty("topology", getTopologyName(topology));
+    result->setProperty("bytesPerEngine", (juce::int64) engines.front()->getMemoryFootprint());
+    result->setProperty("nsPerSample", 1.0e9 * seconds / streamSamples);
+    result->setProperty("realtimeStreams", streamSamples / sampleRate / seconds);
+    return juce::var(result);
+}
+
+//==============================================================================
+// --rt-check: drives processBlock through every processing path while parameters move
+// on every block, and across a state recall, and reports anything the audio thread
+// allocated, freed or locked.
+// Needs a build with EQOON_RT_CHECKS=1, which the Debug configuration sets.
+
+static int runRealtimeCheck()
+{
+    if (! RealtimeSafety::isEnabled())
+    {
+        std::cerr << "--rt-check needs a build with EQOON_RT_CHECKS=1 (the Debug configuration)" << std::endl;
+        return 2;
+    }
+
+    const int blockSizes[] = { 1, 17, 64, 512 };
+    const int maxBlockSize = 512;
+    juce::Random random(0x45516f6f);
+    juce::MidiBuffer midi;
+
+    RealtimeSafety::reset();
+
+    for (auto topology : { FilterTopology::biquad, FilterTopology::svf, FilterTopology::parallel })
+    {
+        for (auto precision : { FilterPrecision::float32, FilterPrecision::float64 })
+        {
+            for (auto hostPrecision : { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision })
+            {
+                for (auto numChannels : { 1, 2, 12 })
+                {
+                    for (auto nonRealtime : { false, true })
+                    {
+                        EQoonAudioProcessor processor;
+                        applyConfiguration(processor, { 48000.0, maxBlockSize, numChannels, Slope_48, 5, topology });
+                        setParameter(processor, "Filter Precision", (float) precision);
+
+                        processor.setProcessingPrecision(hostPrecision);
+                        processor.setNonRealtime(nonRealtime);
+                        processor.setRateAndBufferSizeDetails(48000.0, maxBlockSize);
+                        processor.prepareToPlay(48000.0, maxBlockSize);
+
+                        juce::AudioBuffer<float> floatBuffer(numChannels, maxBlockSize);
+                        juce::AudioBuffer<double> doubleBuffer(numChannels, maxBlockSize);
+                        auto& parameters = processor.getParameters();
+
+                        for (auto blockSize : blockSizes)
+                        {
+                            juce::MemoryBlock state;
+                            processor.getStateInformation(state);
+
+                            for (int block = 0; block < 64; ++block)
+                            {
+                                // Recalls the state from before the moves, which crossfades
+                                // over the next blocks.
+                                if (block == 16)
+                                    processor.setStateInformation(state.getData(), (int) state.getSize());
+
+                                for (int change = 1 + random.nextInt(3); --change >= 0;)
+                                    parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+
+                                // Automation points inside the block, which split it.
+                                for (int event = random.nextInt(4); --event >= 0;)
+                                    processor.addParameterEvent(random.nextInt(parameters.size()), random.nextInt(blockSize),
+                                                                random.nextFloat());
+
+                                // Gives the design thread time to publish now and then.
+                                if (block % 8 == 0)
+                                    juce::Thread::sleep(3);
+
+                                // The second half is silent, so short tails go idle.
+                                auto level = block < 32 ? 0.25 : 0.0;
+
+                                if (hostPrecision == juce::AudioProcessor::doublePrecision)
+                                {
+                                    juce::AudioBuffer<double> view(doubleBuffer.getArrayOfWritePointers(), numChannels, blockSize);
+                                    for (int channel = 0; channel < numChannels; ++channel)
+                                        for (int i = 0; i < blockSize; ++i)
+                                            view.setSample(channel, i, level * (2.0 * random.nextDouble() - 1.0));
+                                    processor.processBlock(view, midi);
+                                }
+                                else
+                                {
+                                    juce::AudioBuffer<float> view(floatBuffer.getArrayOfWritePointers(), numChannels, blockSize);
+                                    for (int channel = 0; channel < numChannels; ++channel)
+                                        for (int i = 0; i < blockSize; ++i)
+                                            view.setSample(channel, i, (float) level * (2.f * random.nextFloat() - 1.f));
+                                    processor.processBlock(view, midi);
+                                }
+                            }
+                        }
+
+                        processor.releaseResources();
+                    }
+                }
+            }
+        }
+    }
+
+    if (RealtimeSafety::getNumViolations() > 0)
+    {
+        std::cerr << RealtimeSafety::getNumViolations() << " real-time safety violations in processBlock:" << std::endl
+                  << RealtimeSafety::getReport() << std::endl;
+        return 1;
+    }
+
+    std::cout << "No allocations, frees or locks in processBlock." << std::endl;
+    return 0;
+}
+
+static juce::var describeSystem()
+{
+    auto* system = new juce::DynamicObject();
+    system->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    system->setProperty("cpu", juce::SystemStats::getCpuModel());
+    system->setProperty("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+    system->setProperty("logicalCpus", juce::SystemStats::getNumCpus());
+    system->setProperty("juce", juce::SystemStats::getJUCEVersion());
+   #if JUCE_DEBUG
+    system->setProperty("build", "Debug");
+   #else
+    system->setProperty("build", "Release");
+   #endif
+    return juce::var(system);
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments(argc, argv);
+
+    if (arguments.containsOption("--rt-check"))
+        return runRealtimeCheck();
+
+    auto runsEngines = arguments.containsOption("--engines");
+
+    auto sweep = arguments.containsOption("--quick")    ? makeQuickSweep()
+               : arguments.containsOption("--cramping") ? makeCrampingSweep()
+               : arguments.containsOption("--routing")  ? makeRoutingSweep()
+               : arguments.containsOption("--dynamics") ? makeDynamicsSweep()
+               : arguments.containsOption("--idle")     ? makeIdleSweep()
+                                                        : Sweep();
+    auto seconds = arguments.containsOption("--seconds")
+                     ? arguments.getValueForOption("--seconds").getDoubleValue()
+                     : (arguments.containsOption("--quick") ? 0.5 : 2.0);
+
+    juce::Array<juce::var> results;
+
+    if (runsEngines)
+    {
+        for (auto topology : sweep.topologies)
+            for (auto numStreams : { 1, 64, 1024 })
+                results.add(runEngines(numStreams, topology, seconds));
+
+        sweep.crampingFixes.clear();
+    }
+
+    for (auto crampingFix : sweep.crampingFixes)
+        for (auto topology : sweep.topologies)
+            for (auto sampleRate : sweep.sampleRates)
+                for (auto numChannels : sweep.channelCounts)
+                    for (auto parallelChannels : sweep.parallelModes)
+                        for (auto routing : sweep.routings)
+                            for (auto dynamics : sweep.dynamicsPresets)
+                                for (auto input : sweep.inputs)
+                                {
+                                    if (parallelChannels && FilterBanks<float>::getNumGroups((size_t) numChannels) < 2)
+                                        continue;
+
+                                    if (numChannels != 2 && routing.name != stereoRouting.name)
+                                        continue;
+
+                                    if (input == InputSignal::partlySilent && numChannels <= 2)
+                                        continue;
+
+                                    for (auto slope : sweep.slopes)
+                                        for (auto activeBands : sweep.activeBands)
+                                            for (auto blockSize : sweep.blockSizes)
+                                                results.add(runConfiguration({ sampleRate, blockSize, numChannels, slope,
+                                                                               activeBands, topology, crampingFix,
+                                                                               parallelChannels, routing, dynamics,
+                                                                               input },
+                                                                             seconds));
+                                }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("benchmark", runsEngines ? "EQoonEngine::process" : "EQoonAudioProcessor::processBlock");
+    report->setProperty("system", describeSystem());
+    report->setProperty("secondsPerConfiguration", seconds);
+    report->setProperty("results", results);
+
+    auto json = juce::JSON::toString(juce::var(report));
+
+    if (arguments.containsOption("--output"))
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(arguments.getValueForOption("--output"));
+
+        if (! file.replaceWithText(json))
+        {
+            std::cerr << "Couldn't write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,750 @@
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <numeric>
+
+/*
+    Offline batch renderer. Loads an EQoon state, as the plug-in's getStateInformation()
+    writes it, and runs a list of audio files through EQoonAudioProcessor on every core
+    without a display, writing one WAV file per input.
+
+    Usage: EQoonRenderer --state <file> --output <directory> [--threads <n>]
+                         [--block-size <samples>] [--chunk-seconds <seconds>]
+                         [--bits <16 | 24 | 32>] [--automation <file>] [--check-seams]
+                         <audio file>...
+
+    Files are cut into chunks of about chunk-seconds, dealt out to one processor per
+    thread in file order. Each thread works through its own queue and steals from the
+    others once it runs dry. Its processor is prepared once per sample rate and channel
+    count, and reset before every chunk. A chunk that doesn't start a file is preceded
+    by a warm-up of the processor's tail and latency, and of the dynamics detectors'
+    settling time, rendered and thrown away, so the filters have settled by the time its
+    own samples come out. The output is shifted back by the reported latency, so it
+    lines up with the input. Finished chunks are written in order as soon as all earlier
+    ones of their file are.
+
+    --automation moves parameters during the render, as AutomationLane describes. The
+    renderer queues their values on every control tick of the file through
+    addParameterEvent(), like a host's sample-accurate automation, so a ramp comes out
+    the same whatever the block size or the chunk.
+
+    --check-seams then renders every file again in memory, in one pass and in chunks,
+    and fails unless they differ by less than -100 dB relative to the peak. Dynamic
+    bands only move their gain in steps of more than 0.01 dB, so the two can hold
+    slightly different gains until the next step and may miss that.
+
+    WAV and AIFF inputs are read through memory-mapped readers; other formats fall back
+    to a stream. The summary reports throughput as x-realtime over all threads and per
+    thread, i.e. per core when there are no more threads than cores, and how the
+    processors' time split between their stages.
+*/
+
+struct RenderOptions
+{
+    juce::File stateFile, outputDirectory;
+    int numThreads = juce::jmax(1, juce::SystemStats::getNumPhysicalCpus());
+    int blockSize = 8192;
+    double chunkSeconds = 30.0;
+    int bitsPerSample = 32;
+    juce::File automationFile;
+    bool checkSeams = false;
+    juce::Array<juce::File> inputs;
+};
+
+struct FileJob
+{
+    juce::File input, output;
+    juce::AudioFormat* format = nullptr;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    juce::int64 lengthInSamples = 0;
+    int numChunks = 0;
+
+    // The ordered commit: chunks that finished before an earlier one wait here.
+    std::mutex lock;
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    std::map<int, juce::AudioBuffer<float>> finishedChunks;
+    int nextChunkToWrite = 0;
+    bool failed = false;
+};
+
+struct ChunkJob
+{
+    FileJob* file;
+    int index;
+    juce::int64 start, end;
+};
+
+/*
+    One queue of chunks per thread. Owners and thieves both take the oldest job, not the
+    newest as a work-stealing deque usually would: the jobs are long enough that the
+    queue locks never contend, and taking them in order keeps the chunks finishing
+    close to file order, so the ordered commit holds few of them.
+*/
+class WorkStealingQueues
+{
+public:
+    explicit WorkStealingQueues(int numQueues) : queues((size_t) numQueues) {}
+
+    void push(int queue, const ChunkJob& job)
+    {
+        const std::lock_guard<std::mutex> lock(queues[(size_t) queue].lock);
+        queues[(size_t) queue].jobs.push_back(job);
+    }
+
+    // The owner's own queue first, then the others in turn.
+    bool pop(int owner, ChunkJob& job)
+    {
+        for (size_t offset = 0; offset < queues.size(); ++offset)
+        {
+            auto& queue = queues[((size_t) owner + offset) % queues.size()];
+            const std::lock_guard<std::mutex> lock(queue.lock);
+
+            if (! queue.jobs.empty())
+            {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<ChunkJob> jobs;
+    };
+
+    std::vector<Queue> queues;
+};
+
+/*
+    One automated parameter, from a JSON object that maps parameter IDs to breakpoints of
+    [seconds, value] in the parameter's own units and in time order:
+
+        { "Peak1 Gain": [[0, 0], [10, 6], [20, 0]], "Peak1 Freq": [[0, 200], [20, 2000]] }
+
+    The value moves linearly between breakpoints and holds before the first and after the
+    last; two breakpoints at one time make a step.
+*/
+struct AutomationLane
+{
+    juce::String parameterID;
+    std::vector<std::pair<double, float>> points;
+
+    float getValueAt(double seconds) const
+    {
+        auto next = std::upper_bound(points.begin(), points.end(), seconds,
+                                     [](double time, const std::pair<double, float>& point) { return time < point.first; });
+
+        if (next == points.begin())
+            return points.front().second;
+        if (next == points.end())
+            return points.back().second;
+
+        auto previous = std::prev(next);
+        auto position = (seconds - previous->first) / (next->first - previous->first);
+        return previous->second + (float) position * (next->second - previous->second);
+    }
+};
+
+// Reports what's wrong and returns false unless the file holds automation of the
+// plug-in's parameters.
+static bool readAutomation(const juce::File& file, std::vector<AutomationLane>& automation)
+{
+    auto* object = juce::JSON::parse(file).getDynamicObject();
+
+    if (object == nullptr)
+    {
+        std::cerr << "Couldn't read automation from " << file.getFullPathName() << std::endl;
+        return false;
+    }
+
+    // Only for its parameter IDs.
+    EQoonAudioProcessor processor;
+
+    for (auto& property : object->getProperties())
+    {
+        AutomationLane lane { property.name.toString(), {} };
+        auto* points = property.value.getArray();
+
+        if (processor.apvts.getParameter(lane.parameterID) == nullptr || points == nullptr || points->isEmpty())
+        {
+            std::cerr << "No parameter or no breakpoints for \"" << lane.parameterID << "\"" << std::endl;
+            return false;
+        }
+
+        for (auto& point : *points)
+        {
+            auto* pair = point.getArray();
+
+            if (pair == nullptr || pair->size() != 2 || (! lane.points.empty() && (double) (*pair)[0] < lane.points.back().first))
+            {
+                std::cerr << "The breakpoints of \"" << lane.parameterID << "\" must be [seconds, value], in time order" << std::endl;
+                return false;
+            }
+
+            lane.points.emplace_back((double) (*pair)[0], (float) (*pair)[1]);
+        }
+
+        automation.push_back(std::move(lane));
+    }
+
+    return true;
+}
+
+static void setParameter(EQoonAudioProcessor& processor, const juce::String& parameterID, float value)
+{
+    auto* parameter = processor.apvts.getParameter(parameterID);
+    jassert(parameter != nullptr);
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+// Reads the chunk's input, from the start of its warm-up, into buffer. Samples past
+// the end of the file stay silent.
+static bool readInput(const FileJob& file, juce::int64 readStart, juce::int64 readEnd, juce::AudioBuffer<float>& buffer)
+{
+    buffer.clear();
+    auto numSamples = (int) (juce::jmin(readEnd, file.lengthInSamples) - readStart);
+
+    if (numSamples <= 0)
+        return true;
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(file.format->createMemoryMappedReader(file.input));
+
+    if (mappedReader != nullptr && mappedReader->mapSectionOfFile({ readStart, readStart + numSamples }))
+        return mappedReader->read(&buffer, 0, numSamples, readStart, true, true);
+
+    std::unique_ptr<juce::AudioFormatReader> reader(file.format->createReaderFor(file.input.createInputStream().release(), true));
+    return reader != nullptr && reader->read(&buffer, 0, numSamples, readStart, true, true);
+}
+
+// How long the dynamic bands' detectors take to forget the audio before a warm-up. Their
+// envelopes close the gap by 1/e per time constant, so 12 of the longest attack or release
+// take it past -100 dB.
+static double getDetectorSettleSeconds(const ChainSettings& settings)
+{
+    if (settings.phaseMode != PhaseMode::minimum)
+        return 0.0;
+
+    auto longestMs = 0.0;
+    for (int position = ChainPositions::LowShelf; position <= ChainPositions::HighShelf; ++position)
+    {
+        const auto& fields = bandFields[(size_t) position];
+        if (settings.*fields.ratio > 1.f)
+            longestMs = juce::jmax(longestMs, (double) (settings.*fields.attack), (double) (settings.*fields.release));
+    }
+
+    return 12.0 * longestMs * 0.001;
+}
+
+/*
+    A processor loaded with the state, which renders chunks of any file. It is prepared
+    once for each sample rate and channel count it meets, and reset between chunks, so
+    the first kernel of a linear phase state is designed and loaded by prepareToPlay(),
+    before any chunk renders, and never again while the settings stay the same.
+
+    Automated parameters start each chunk at their values where its warm-up starts, and
+    from there follow the automation through addParameterEvent(), on the file's control
+    grid. Blocks are shortened so every lane's events for a block fit in the queue.
+*/
+class ChunkRenderer
+{
+public:
+    ChunkRenderer(const juce::MemoryBlock& state, const std::vector<AutomationLane>& automation, int blockSizeToUse)
+        : blockSize(blockSizeToUse)
+    {
+        // The state is loaded here, on the message thread, like a host would.
+        processor.setNonRealtime(true);
+        processor.setStateInformation(state.getData(), (int) state.getSize());
+
+        // The files already keep every core busy.
+        setParameter(processor, "Parallel Channels", 0.f);
+
+        for (auto& lane : automation)
+        {
+            auto* parameter = processor.apvts.getParameter(lane.parameterID);
+            jassert(parameter != nullptr);
+            lanes.push_back({ &lane, parameter, 0.f });
+        }
+
+        if (! lanes.empty())
+        {
+            auto ticksPerBlock = juce::jmax(1, ParameterEventQueue::capacity / (int) lanes.size() - 1);
+            blockSize = juce::jmin(blockSize, ticksPerBlock * SnapshotGlide::controlInterval);
+        }
+    }
+
+    ~ChunkRenderer()
+    {
+        release();
+    }
+
+    // Renders one chunk and returns the samples it owns.
+    bool render(const ChunkJob& job, juce::AudioBuffer<float>& result)
+    {
+        const auto& file = *job.file;
+
+        if (! prepareFor(file))
+            return false;
+
+        // A warm-up on the control grid samples the dynamics and the automation where one
+        // pass would. Automation also has to wait for the glide it jumped past to settle,
+        // which closes the gap by 1/e per ramp length.
+        auto latency = (juce::int64) processor.getLatencySamples();
+        auto settleSeconds = processor.getTailLengthSeconds()
+                           + getDetectorSettleSeconds(processor.getLatestSnapshot().settings)
+                           + (lanes.empty() ? 0.0 : 12.0 * ChainSettingsSmoother::rampLengthSeconds);
+        auto warmUp = job.start > 0 ? (juce::int64) std::ceil(settleSeconds * file.sampleRate) + latency : 0;
+        auto readStart = juce::jmax((juce::int64) 0, job.start - warmUp);
+        readStart -= readStart % SnapshotGlide::controlInterval;
+        auto readEnd = job.end + latency;
+
+        for (auto& lane : lanes)
+        {
+            lane.value = lane.parameter->convertTo0to1(lane.automation->getValueAt((double) readStart / file.sampleRate));
+            lane.parameter->setValueNotifyingHost(lane.value);
+        }
+
+        processor.reset();
+
+        juce::AudioBuffer<float> buffer(file.numChannels, (int) (readEnd - readStart));
+
+        if (! readInput(file, readStart, readEnd, buffer))
+            return false;
+
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            auto length = juce::jmin(blockSize, buffer.getNumSamples() - start);
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), file.numChannels, start, length);
+            queueAutomation(readStart + start, length, file.sampleRate);
+            processor.processBlock(block, midi);
+        }
+
+        auto skip = (int) (job.start - readStart + latency);
+        result.setSize(file.numChannels, (int) (job.end - job.start));
+
+        for (int channel = 0; channel < file.numChannels; ++channel)
+            result.copyFrom(channel, 0, buffer, channel, skip, result.getNumSamples());
+
+        return true;
+    }
+
+    // Adds up the meter, which starts again with every prepareToPlay(), and releases.
+    void release()
+    {
+        if (preparedNumChannels == 0)
+            return;
+
+        auto load = processor.getProcessLoad();
+        for (size_t stage = 0; stage < stageSeconds.size(); ++stage)
+            stageSeconds[stage] += load.stageSeconds[stage];
+
+        processor.releaseResources();
+        preparedSampleRate = 0.0;
+        preparedNumChannels = 0;
+    }
+
+    // Time the processor spent in each stage, up to the last release().
+    std::array<double, ProcessLoadMeter::numStages> stageSeconds {};
+
+private:
+    struct Lane
+    {
+        const AutomationLane* automation;
+        juce::RangedAudioParameter* parameter;
+        float value; // Normalised, as last queued
+    };
+
+    EQoonAudioProcessor processor;
+    std::vector<Lane> lanes;
+    int blockSize;
+    double preparedSampleRate = 0.0;
+    int preparedNumChannels = 0;
+
+    // Queues each lane's value on the ticks of the block that starts at blockStart in the
+    // file, where it has moved since the last.
+    void queueAutomation(juce::int64 blockStart, int length, double sampleRate)
+    {
+        constexpr auto step = (juce::int64) SnapshotGlide::controlInterval;
+        auto firstTick = (blockStart + step - 1) / step * step;
+
+        for (auto& lane : lanes)
+        {
+            auto index = lane.parameter->getParameterIndex();
+
+            for (auto tick = firstTick; tick < blockStart + length; tick += step)
+            {
+                auto value = lane.parameter->convertTo0to1(lane.automation->getValueAt((double) tick / sampleRate));
+
+                if (value != lane.value)
+                {
+                    auto queued = processor.addParameterEvent(index, (int) (tick - blockStart), value);
+                    jassert(queued);
+                    juce::ignoreUnused(queued);
+                    lane.value = value;
+                }
+            }
+        }
+    }
+
+    bool prepareFor(const FileJob& file)
+    {
+        if (file.sampleRate == preparedSampleRate && file.numChannels == preparedNumChannels)
+            return true;
+
+        release();
+
+        auto channelSet = juce::AudioChannelSet::canonicalChannelSet(file.numChannels);
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.inputBuses.add(juce::AudioChannelSet::disabled());
+        layout.outputBuses.add(channelSet);
+
+        if (! processor.setBusesLayout(layout))
+            return false;
+
+        processor.setRateAndBufferSizeDetails(file.sampleRate, blockSize);
+        processor.prepareToPlay(file.sampleRate, blockSize);
+        preparedSampleRate = file.sampleRate;
+        preparedNumChannels = file.numChannels;
+        return true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(ChunkRenderer)
+};
+
+// Chunks split the file evenly, in samples.
+static ChunkJob getChunk(FileJob& file, int index)
+{
+    auto chunkLength = (file.lengthInSamples + file.numChunks - 1) / file.numChunks;
+    auto start = index * chunkLength;
+    return { &file, index, start, juce::jmin(file.lengthInSamples, start + chunkLength) };
+}
+
+static void commitChunk(FileJob& file, int index, juce::AudioBuffer<float>&& audio, bool rendered)
+{
+    const std::lock_guard<std::mutex> lock(file.lock);
+
+    if (! rendered)
+        file.failed = true;
+
+    if (file.failed)
+    {
+        file.writer.reset();
+        return;
+    }
+
+    file.finishedChunks.emplace(index, std::move(audio));
+
+    for (auto next = file.finishedChunks.find(file.nextChunkToWrite); next != file.finishedChunks.end();
+         next = file.finishedChunks.find(file.nextChunkToWrite))
+    {
+        if (! file.writer->writeFromAudioSampleBuffer(next->second, 0, next->second.getNumSamples()))
+        {
+            file.failed = true;
+            file.writer.reset();
+            return;
+        }
+
+        file.finishedChunks.erase(next);
+        ++file.nextChunkToWrite;
+    }
+
+    // Closing the writer finishes the file's header.
+    if (file.nextChunkToWrite == file.numChunks)
+        file.writer.reset();
+}
+
+class RenderWorker : public juce::Thread
+{
+public:
+    RenderWorker(int index, WorkStealingQueues& queuesToUse, const juce::MemoryBlock& state,
+                 const std::vector<AutomationLane>& automation, int blockSize)
+        : juce::Thread("EQoon Renderer " + juce::String(index)),
+          workerIndex(index),
+          queues(queuesToUse),
+          renderer(state, automation, blockSize)
+    {
+    }
+
+    void run() override
+    {
+        ChunkJob job;
+
+        while (! threadShouldExit() && queues.pop(workerIndex, job))
+        {
+            juce::AudioBuffer<float> audio;
+            auto rendered = renderer.render(job, audio);
+            commitChunk(*job.file, job.index, std::move(audio), rendered);
+        }
+
+        renderer.release();
+    }
+
+    // Read once the thread has stopped.
+    const std::array<double, ProcessLoadMeter::numStages>& getStageSeconds() const noexcept
+    {
+        return renderer.stageSeconds;
+    }
+
+private:
+    int workerIndex;
+    WorkStealingQueues& queues;
+    ChunkRenderer renderer;
+};
+
+/*
+    Renders every file again, in memory and on one thread: in one pass and in its chunks,
+    as a worker would. Reports, per file, the largest difference between the two relative
+    to the peak of the one pass, and returns false if any is above maxSeamDecibels.
+*/
+static bool checkSeams(const std::vector<std::unique_ptr<FileJob>>& files, const juce::MemoryBlock& state,
+                       const std::vector<AutomationLane>& automation, int blockSize)
+{
+    constexpr float maxSeamDecibels = -100.f;
+    ChunkRenderer renderer(state, automation, blockSize);
+    auto passed = true;
+
+    for (auto& file : files)
+    {
+        juce::AudioBuffer<float> onePass, chunk;
+        auto rendered = renderer.render({ file.get(), 0, 0, file->lengthInSamples }, onePass);
+        auto maxDifference = 0.f;
+
+        for (int index = 0; rendered && index < file->numChunks; ++index)
+        {
+            auto job = getChunk(*file, index);
+            rendered = renderer.render(job, chunk);
+
+            for (int channel = 0; rendered && channel < file->numChannels; ++channel)
+            {
+                auto* expected = onePass.getReadPointer(channel, (int) job.start);
+                auto* actual = chunk.getReadPointer(channel);
+
+                for (int sample = 0; sample < chunk.getNumSamples(); ++sample)
+                    maxDifference = juce::jmax(maxDifference, std::abs(actual[sample] - expected[sample]));
+            }
+        }
+
+        if (! rendered)
+        {
+            std::cerr << "Failed to check the seams of " << file->input.getFullPathName() << std::endl;
+            passed = false;
+            continue;
+        }
+
+        auto peak = onePass.getMagnitude(0, onePass.getNumSamples());
+        auto seamDecibels = juce::Decibels::gainToDecibels(peak > 0.f ? maxDifference / peak : 0.f, -200.f);
+        passed = passed && seamDecibels <= maxSeamDecibels;
+
+        std::cout << "Seams in " << file->input.getFileName() << ": " << juce::String(seamDecibels, 1)
+                  << " dB below the peak" << (seamDecibels <= maxSeamDecibels ? "" : ", above the limit") << std::endl;
+    }
+
+    return passed;
+}
+
+static juce::StringArray getOptionsWithValues()
+{
+    return { "--state", "--output", "--threads", "--block-size", "--chunk-seconds", "--bits", "--automation" };
+}
+
+static bool parseOptions(const juce::ArgumentList& arguments, RenderOptions& options)
+{
+    auto optionsWithValues = getOptionsWithValues();
+
+    for (int index = 0; index < arguments.size(); ++index)
+    {
+        auto text = arguments[index].text;
+
+        if (optionsWithValues.contains(text))
+            ++index;
+        else if (! text.startsWith("--"))
+            options.inputs.add(arguments[index].resolveAsFile());
+    }
+
+    if (! arguments.containsOption("--state") || ! arguments.containsOption("--output") || options.inputs.isEmpty())
+        return false;
+
+    options.stateFile = arguments.getFileForOption("--state");
+    options.outputDirectory = arguments.getFileForOption("--output");
+
+    if (arguments.containsOption("--threads"))
+        options.numThreads = juce::jmax(1, arguments.getValueForOption("--threads").getIntValue());
+    if (arguments.containsOption("--block-size"))
+        options.blockSize = juce::jlimit(32, 1 << 16, arguments.getValueForOption("--block-size").getIntValue());
+    if (arguments.containsOption("--chunk-seconds"))
+        options.chunkSeconds = juce::jmax(1.0, arguments.getValueForOption("--chunk-seconds").getDoubleValue());
+    if (arguments.containsOption("--bits"))
+        options.bitsPerSample = arguments.getValueForOption("--bits").getIntValue();
+
+    if (arguments.containsOption("--automation"))
+        options.automationFile = arguments.getFileForOption("--automation");
+
+    options.checkSeams = arguments.containsOption("--check-seams");
+
+    return options.bitsPerSample == 16 || options.bitsPerSample == 24 || options.bitsPerSample == 32;
+}
+
+// Opens every input and creates its output writer; files that can't be read or written
+// are reported and left out.
+static std::vector<std::unique_ptr<FileJob>> openFiles(const RenderOptions& options, juce::AudioFormatManager& formats)
+{
+    std::vector<std::unique_ptr<FileJob>> files;
+    juce::WavAudioFormat wav;
+
+    for (auto& input : options.inputs)
+    {
+        auto file = std::make_unique<FileJob>();
+        file->input = input;
+        file->format = formats.findFormatForFileExtension(input.getFileExtension());
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+
+        if (file->format == nullptr || reader == nullptr)
+        {
+            std::cerr << "Couldn't read " << input.getFullPathName() << std::endl;
+            continue;
+        }
+
+        file->sampleRate = reader->sampleRate;
+        file->numChannels = (int) reader->numChannels;
+        file->lengthInSamples = reader->lengthInSamples;
+
+        auto chunkLength = juce::jmax((juce::int64) 1, (juce::int64) (options.chunkSeconds * file->sampleRate));
+        file->numChunks = (int) juce::jmax((juce::int64) 1, (file->lengthInSamples + chunkLength - 1) / chunkLength);
+
+        file->output = options.outputDirectory.getChildFile(input.getFileNameWithoutExtension() + ".wav");
+        file->output.deleteFile();
+
+        if (std::unique_ptr<juce::OutputStream> stream = file->output.createOutputStream())
+        {
+            file->writer.reset(wav.createWriterFor(stream.get(), file->sampleRate, (unsigned int) file->numChannels,
+                                                   options.bitsPerSample, {}, 0));
+
+            // The writer owns the stream once it exists.
+            if (file->writer != nullptr)
+                stream.release();
+        }
+
+        if (file->writer == nullptr)
+        {
+            std::cerr << "Couldn't write " << file->output.getFullPathName() << std::endl;
+            continue;
+        }
+
+        files.push_back(std::move(file));
+    }
+
+    return files;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments(argc, argv);
+    RenderOptions options;
+
+    if (! parseOptions(arguments, options))
+    {
+        std::cerr << "Usage: EQoonRenderer --state <file> --output <directory> [--threads <n>]" << std::endl
+                  << "                     [--block-size <samples>] [--chunk-seconds <seconds>]" << std::endl
+                  << "                     [--bits <16 | 24 | 32>] [--automation <file>] [--check-seams]" << std::endl
+                  << "                     <audio file>..." << std::endl;
+        return 1;
+    }
+
+    juce::MemoryBlock state;
+
+    if (! options.stateFile.loadFileAsData(state) || ! options.outputDirectory.createDirectory())
+    {
+        std::cerr << "Couldn't read the state or create the output directory" << std::endl;
+        return 1;
+    }
+
+    std::vector<AutomationLane> automation;
+
+    if (options.automationFile != juce::File() && ! readAutomation(options.automationFile, automation))
+        return 1;
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    auto files = openFiles(options, formats);
+
+    // Chunks are dealt round-robin in file order, so every thread starts near the front.
+    WorkStealingQueues queues(options.numThreads);
+    double audioSeconds = 0.0;
+    int chunkIndex = 0;
+
+    for (auto& file : files)
+    {
+        audioSeconds += (double) file->lengthInSamples / file->sampleRate;
+
+        for (int chunk = 0; chunk < file->numChunks; ++chunk)
+            queues.push(chunkIndex++ % options.numThreads, getChunk(*file, chunk));
+    }
+
+    juce::OwnedArray<RenderWorker> workers;
+    for (int index = 0; index < options.numThreads; ++index)
+        workers.add(new RenderWorker(index, queues, state, automation, options.blockSize));
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        while (worker->isThreadRunning())
+            juce::Thread::sleep(10);
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    std::array<double, ProcessLoadMeter::numStages> stageSeconds {};
+    for (auto* worker : workers)
+        for (size_t stage = 0; stage < stageSeconds.size(); ++stage)
+            stageSeconds[stage] += worker->getStageSeconds()[stage];
+
+    workers.clear();
+
+    auto numFailed = 0;
+    for (auto& file : files)
+    {
+        if (file->failed)
+        {
+            std::cerr << "Failed to render " << file->input.getFullPathName() << std::endl;
+            file->output.deleteFile();
+            ++numFailed;
+        }
+    }
+
+    auto realtimeFactor = seconds > 0.0 ? audioSeconds / seconds : 0.0;
+    std::cout << "Rendered " << (int) files.size() - numFailed << " of " << options.inputs.size() << " files, "
+              << audioSeconds << " s of audio in " << seconds << " s on " << options.numThreads << " threads: "
+              << realtimeFactor << "x realtime, " << realtimeFactor / options.numThreads << "x realtime per core"
+              << std::endl;
+
+    auto processSeconds = std::accumulate(stageSeconds.begin(), stageSeconds.end(), 0.0);
+
+    if (processSeconds > 0.0)
+    {
+        std::cout << "Time in processBlock:";
+        for (size_t stage = 0; stage < stageSeconds.size(); ++stage)
+            std::cout << (stage > 0 ? ", " : " ") << ProcessLoadMeter::getStageName((ProcessLoadMeter::Stage) stage) << " "
+                      << juce::String(100.0 * stageSeconds[stage] / processSeconds, 1) << "%";
+        std::cout << std::endl;
+    }
+
+    auto seamsPassed = ! options.checkSeams || checkSeams(files, state, automation, options.blockSize);
+
+    return numFailed == 0 && (int) files.size() == options.inputs.size() && seamsPassed ? 0 : 1;
+}
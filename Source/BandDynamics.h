@@ -0,0 +1,251 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "InterleavedBuffer.h"
+
+/*
+    Level detectors for the dynamic bands. Each band listens to its own part of the
+    spectrum through a TPT state-variable filter at its frequency and Q: band-pass for
+    a peak, low-pass for a low shelf and high-pass for a high shelf. A peak envelope
+    with the band's attack and release follows the filtered signal.
+
+    process() runs once per host block, before the filters, over the main input or the
+    sidechain, and keeps every band's envelope at every sample of the block. The
+    processor samples the envelopes at its control ticks and turns them into gain
+    changes with getGainChangeDecibels(), so dynamics go through the same fast redesign
+    and SVF ramp as a parameter glide instead of redesigning every sample.
+
+    Stereo bands filter every channel and follow the loudest (linked peak detection), so
+    a level reads the same whatever the layout, the panning or the phase between the
+    channels. Mid bands detect on the mean of the channels. On a stereo input, left,
+    right and side bands detect on the signal they filter; other layouts have no
+    left, right or side, so those bands are linked too.
+*/
+class BandDynamics
+{
+public:
+    static constexpr size_t maxBands = 5;
+
+    enum class Detector
+    {
+        bandPass,
+        lowPass,
+        highPass
+    };
+
+    struct Band
+    {
+        bool enabled;
+        Detector detector;
+        float frequency, quality;
+        float attackMs, releaseMs;
+        ChannelRouting routing;
+    };
+
+    // maximumChannels must cover the main input and the sidechain, whichever is wider.
+    void prepare(double newSampleRate, int maximumBlockSize, int maximumChannels)
+    {
+        sampleRate = newSampleRate;
+        levels.setSize((int) maxBands, maximumBlockSize);
+        levels.clear();
+        maxChannels = (size_t) juce::jmax(1, maximumChannels);
+        filters.assign(maxBands * maxChannels, {});
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& state : states)
+            state = {};
+
+        std::fill(filters.begin(), filters.end(), Filter {});
+    }
+
+    // Call from the audio thread before process(); cheap enough to call every block.
+    void setBand(size_t index, const Band& band) noexcept
+    {
+        jassert(index < maxBands);
+        auto& state = states[index];
+
+        if (! band.enabled)
+        {
+            state = {};
+            std::fill_n(filters.begin() + (std::ptrdiff_t) (index * maxChannels), maxChannels, Filter {});
+            return;
+        }
+
+        auto g = std::tan(juce::MathConstants<double>::pi
+                          * juce::jmin((double) band.frequency, 0.49 * sampleRate) / sampleRate);
+        auto k = 1.0 / juce::jmax(0.01, (double) band.quality);
+
+        state.enabled = true;
+        state.band = band;
+        state.k = k;
+        state.a1 = 1.0 / (1.0 + g * (g + k));
+        state.a2 = g * state.a1;
+        state.a3 = g * state.a2;
+        state.attack = getEnvelopeCoefficient(band.attackMs);
+        state.release = getEnvelopeCoefficient(band.releaseMs);
+    }
+
+    bool isEnabled(size_t index) const noexcept
+    {
+        return states[index].enabled;
+    }
+
+    template <typename SampleType>
+    void process(const juce::dsp::AudioBlock<const SampleType>& input) noexcept
+    {
+        auto numSamples = (int) juce::jmin(input.getNumSamples(), (size_t) levels.getNumSamples());
+        lastNumSamples = numSamples;
+
+        auto numChannels = input.getNumChannels();
+
+        for (size_t index = 0; index < maxBands; ++index)
+        {
+            auto& state = states[index];
+            auto* level = levels.getWritePointer((int) index);
+            auto* bandFilters = filters.data() + index * maxChannels;
+            auto linked = isLinked(numChannels, state.band.routing);
+            auto numInputs = linked ? juce::jmin(numChannels, maxChannels) : (size_t) 1;
+
+            if (! state.enabled)
+            {
+                juce::FloatVectorOperations::clear(level, numSamples);
+                continue;
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto rectified = 0.0;
+
+                for (size_t channel = 0; channel < numInputs; ++channel)
+                {
+                    auto x = linked ? (double) input.getSample((int) channel, i)
+                                    : getDetectorInput(input, state.band.routing, (size_t) i);
+                    rectified = juce::jmax(rectified, std::abs(filterSample(state, bandFilters[channel], x)));
+                }
+
+                auto coefficient = rectified > state.envelope ? state.attack : state.release;
+                state.envelope = rectified + coefficient * (state.envelope - rectified);
+                level[i] = (float) state.envelope;
+            }
+
+            for (size_t channel = 0; channel < numInputs; ++channel)
+            {
+                JUCE_SNAP_TO_ZERO(bandFilters[channel].ic1);
+                JUCE_SNAP_TO_ZERO(bandFilters[channel].ic2);
+            }
+        }
+    }
+
+    // The envelope after sample index of the last block processed; an index past its
+    // end reads its last sample.
+    float getLevelDecibels(size_t band, int sampleIndex) const noexcept
+    {
+        if (lastNumSamples == 0)
+            return -100.f;
+
+        auto index = juce::jlimit(0, lastNumSamples - 1, sampleIndex);
+        return juce::Decibels::gainToDecibels(levels.getSample((int) band, index), -100.f);
+    }
+
+    // Downward compression with a 6 dB soft knee, in dB (zero or negative), limited to
+    // maxGainChangeDecibels.
+    static float getGainChangeDecibels(float levelDecibels, float thresholdDecibels, float ratio) noexcept
+    {
+        constexpr float kneeDecibels = 6.f;
+        auto slope = 1.f / juce::jmax(1.f, ratio) - 1.f;
+        auto over = levelDecibels - thresholdDecibels;
+        float change;
+
+        if (2.f * over < -kneeDecibels)
+            change = 0.f;
+        else if (2.f * std::abs(over) <= kneeDecibels)
+            change = slope * (over + 0.5f * kneeDecibels) * (over + 0.5f * kneeDecibels) / (2.f * kneeDecibels);
+        else
+            change = slope * over;
+
+        return juce::jmax(-maxGainChangeDecibels, change);
+    }
+
+    static constexpr float maxGainChangeDecibels = 24.f;
+
+private:
+    struct State
+    {
+        bool enabled = false;
+        Band band {};
+        double k = 0.0, a1 = 0.0, a2 = 0.0, a3 = 0.0;
+        double attack = 0.0, release = 0.0, envelope = 0.0;
+    };
+
+    // The integrators of one channel's detector filter.
+    struct Filter
+    {
+        double ic1 = 0.0, ic2 = 0.0;
+    };
+
+    std::array<State, maxBands> states;
+    std::vector<Filter> filters; // maxChannels per band
+    size_t maxChannels = 1;
+    juce::AudioBuffer<float> levels;
+    double sampleRate = 44100.0;
+    int lastNumSamples = 0;
+
+    double getEnvelopeCoefficient(float milliseconds) const noexcept
+    {
+        return std::exp(-1.0 / (juce::jmax(0.01, (double) milliseconds) * 0.001 * sampleRate));
+    }
+
+    static double filterSample(const State& state, Filter& filter, double x) noexcept
+    {
+        auto v3 = x - filter.ic2;
+        auto v1 = state.a1 * filter.ic1 + state.a2 * v3;
+        auto v2 = filter.ic2 + state.a2 * filter.ic1 + state.a3 * v3;
+        filter.ic1 = 2.0 * v1 - filter.ic1;
+        filter.ic2 = 2.0 * v2 - filter.ic2;
+
+        return state.band.detector == Detector::bandPass ? state.k * v1
+             : state.band.detector == Detector::lowPass  ? v2
+                                                         : x - state.k * v1 - v2;
+    }
+
+    // Whether the band detects on every channel rather than on one signal of them.
+    static bool isLinked(size_t numChannels, ChannelRouting routing) noexcept
+    {
+        return routing == ChannelRouting::stereo || (numChannels != 2 && routing != ChannelRouting::mid);
+    }
+
+    // The one signal an unlinked band detects on.
+    template <typename SampleType>
+    static double getDetectorInput(const juce::dsp::AudioBlock<const SampleType>& input, ChannelRouting routing,
+                                   size_t i) noexcept
+    {
+        auto numChannels = input.getNumChannels();
+
+        if (numChannels == 2)
+        {
+            auto left = (double) input.getSample(0, (int) i);
+            auto right = (double) input.getSample(1, (int) i);
+
+            switch (routing)
+            {
+                case ChannelRouting::left:   return left;
+                case ChannelRouting::right:  return right;
+                case ChannelRouting::side:   return (left - right) * 0.5;
+                case ChannelRouting::mid:
+                case ChannelRouting::stereo:
+                default:                     return (left + right) * 0.5;
+            }
+        }
+
+        // Mid, the mean of all channels.
+
+        double sum = 0.0;
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            sum += (double) input.getSample((int) channel, (int) i);
+
+        return numChannels > 0 ? sum / (double) numChannels : 0.0;
+    }
+};
@@ -0,0 +1,82 @@
+#include "ChannelWorkerPool.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+#if JUCE_WINDOWS
+
+struct WakeSemaphore::Pimpl
+{
+    HANDLE handle = CreateSemaphoreW(nullptr, 0, std::numeric_limits<LONG>::max(), nullptr);
+
+    ~Pimpl() { CloseHandle(handle); }
+
+    void post(int count) noexcept { ReleaseSemaphore(handle, (LONG) count, nullptr); }
+    void wait() noexcept          { WaitForSingleObject(handle, INFINITE); }
+};
+
+#elif JUCE_MAC || JUCE_IOS
+
+struct WakeSemaphore::Pimpl
+{
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+
+    ~Pimpl() { dispatch_release(semaphore); }
+
+    void post(int count) noexcept
+    {
+        for (int i = 0; i < count; ++i)
+            dispatch_semaphore_signal(semaphore);
+    }
+
+    void wait() noexcept { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+};
+
+#else
+
+struct WakeSemaphore::Pimpl
+{
+    sem_t semaphore;
+
+    Pimpl()  { sem_init(&semaphore, 0, 0); }
+    ~Pimpl() { sem_destroy(&semaphore); }
+
+    void post(int count) noexcept
+    {
+        for (int i = 0; i < count; ++i)
+            sem_post(&semaphore);
+    }
+
+    // Signals interrupt the wait without taking a count.
+    void wait() noexcept
+    {
+        while (sem_wait(&semaphore) != 0 && errno == EINTR)
+        {
+        }
+    }
+};
+
+#endif
+
+WakeSemaphore::WakeSemaphore() : pimpl(std::make_unique<Pimpl>()) {}
+WakeSemaphore::~WakeSemaphore() = default;
+
+void WakeSemaphore::post(int count) noexcept
+{
+    if (count > 0)
+        pimpl->post(count);
+}
+
+void WakeSemaphore::wait() noexcept
+{
+    pimpl->wait();
+}
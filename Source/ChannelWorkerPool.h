@@ -0,0 +1,170 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    A few worker threads that help the audio thread through independent jobs, such as
+    the channel groups of a wide bus.
+
+    run() publishes the jobs and then works through them itself alongside the workers.
+    Each job is claimed with one compare-and-swap on a ticket holding the run's
+    generation, job count and next index, so a worker that wakes late can never claim
+    a job of a later run. A worker parks on a WakeSemaphore as
+    soon as it finds no job left to claim, so it costs no CPU between blocks. run() posts
+    the semaphore once for the workers that have parked, which never locks; a worker
+    that parks just too late sleeps through that run. If none of them is awake, run()
+    just does every job itself.
+
+    run() returns once every job has finished, so it may spin briefly, without giving
+    up its time slice, while a worker completes a job it already claimed. The workers run at real-time priority where
+    the platform allows it, so a busy machine doesn't preempt them in the middle of a
+    job the audio thread waits for. Only one thread may call run() at a time.
+    Constructing and destroying the pool starts and stops its threads, so neither
+    belongs on the audio thread.
+*/
+
+// A counting semaphore on the platform's own primitive. post() is one system call at
+// most and never takes a lock, unlike juce::WaitableEvent, so the audio thread may call it.
+class WakeSemaphore
+{
+public:
+    WakeSemaphore();
+    ~WakeSemaphore();
+
+    void post(int count) noexcept;
+    void wait() noexcept;
+
+private:
+    struct Pimpl;
+    std::unique_ptr<Pimpl> pimpl;
+
+    JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+};
+
+class ChannelWorkerPool
+{
+public:
+    explicit ChannelWorkerPool(int numWorkers)
+    {
+        for (int index = 0; index < numWorkers; ++index)
+        {
+            auto* worker = workers.add(new Worker(*this));
+            if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions {}))
+                worker->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    ~ChannelWorkerPool()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        wakeUp.post(workers.size());
+
+        for (auto* worker : workers)
+            worker->stopThread(1000);
+    }
+
+    int getNumWorkers() const noexcept
+    {
+        return workers.size();
+    }
+
+    // Calls job(index) once for every index below numJobs and returns when all calls
+    // have returned. The job must be safe to run on several threads at once.
+    template <typename Job>
+    void run(int numJobs, Job& job) noexcept
+    {
+        jassert(numJobs <= maxJobs);
+
+        jobFunction.store([](void* context, int index) { (*static_cast<Job*>(context))(index); },
+                          std::memory_order_relaxed);
+        jobContext.store(&job, std::memory_order_relaxed);
+        jobsDone.store(0, std::memory_order_relaxed);
+
+        auto generation = getGeneration(ticket.load(std::memory_order_relaxed)) + 1;
+        ticket.store(makeTicket(generation, numJobs, 0), std::memory_order_release);
+
+        if (auto numToWake = numParked.exchange(0))
+            wakeUp.post(numToWake);
+
+        while (claimAndRun(generation))
+        {
+        }
+
+        while (jobsDone.load(std::memory_order_acquire) < numJobs)
+        {
+        }
+    }
+
+private:
+    using JobFunction = void (*)(void* context, int index);
+
+    static constexpr int maxJobs = 0xffff;
+
+    struct Worker : juce::Thread
+    {
+        explicit Worker(ChannelWorkerPool& owner) : juce::Thread("EQoon Channel Worker"), pool(owner) {}
+
+        void run() override
+        {
+            juce::uint32 lastGeneration = 0;
+
+            while (! threadShouldExit())
+            {
+                auto generation = getGeneration(pool.ticket.load(std::memory_order_acquire));
+
+                if (generation != lastGeneration)
+                {
+                    lastGeneration = generation;
+                    while (pool.claimAndRun(generation))
+                    {
+                    }
+                }
+
+                // Counted before it sleeps, so the next run() posts for it.
+                pool.numParked.fetch_add(1);
+                pool.wakeUp.wait();
+            }
+        }
+
+        ChannelWorkerPool& pool;
+    };
+
+    // Generation in the top 32 bits, then the job count and the next job index.
+    std::atomic<juce::uint64> ticket { 0 };
+    std::atomic<JobFunction> jobFunction { nullptr };
+    std::atomic<void*> jobContext { nullptr };
+    std::atomic<int> jobsDone { 0 };
+    std::atomic<int> numParked { 0 };
+    WakeSemaphore wakeUp;
+    juce::OwnedArray<Worker> workers;
+
+    static juce::uint64 makeTicket(juce::uint32 generation, int numJobs, int nextJob) noexcept
+    {
+        return ((juce::uint64) generation << 32) | ((juce::uint64) numJobs << 16) | (juce::uint64) nextJob;
+    }
+
+    static juce::uint32 getGeneration(juce::uint64 value) noexcept  { return (juce::uint32) (value >> 32); }
+    static int getNumJobs(juce::uint64 value) noexcept             { return (int) ((value >> 16) & maxJobs); }
+    static int getNextJob(juce::uint64 value) noexcept             { return (int) (value & maxJobs); }
+
+    bool claimAndRun(juce::uint32 generation) noexcept
+    {
+        auto current = ticket.load(std::memory_order_acquire);
+
+        do
+        {
+            if (getGeneration(current) != generation || getNextJob(current) >= getNumJobs(current))
+                return false;
+        }
+        while (! ticket.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel,
+                                              std::memory_order_acquire));
+
+        jobFunction.load(std::memory_order_relaxed)(jobContext.load(std::memory_order_relaxed), getNextJob(current));
+        jobsDone.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(ChannelWorkerPool)
+};
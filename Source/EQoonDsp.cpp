@@ -0,0 +1,774 @@
+#include "EQoonDsp.h"
+
+double getButterworthSectionQuality(int order, int section)
+{
+    return 1.0 / (2.0 * std::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+}
+
+template<typename CoefficientsType, typename DesignFunction>
+static std::array<CoefficientsType, 4> makeButterworthSections(Slope slope, float quality, const CoefficientsType& identity,
+                                                               DesignFunction&& design)
+{
+    std::array<CoefficientsType, 4> sections;
+    sections.fill(identity);
+
+    auto numStages = slope + 1;
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        // The quality parameter scales only the most resonant section, so it shapes the
+        // corner the same way for every slope and 1 leaves a pure Butterworth response.
+        auto sectionQuality = getButterworthSectionQuality(2 * numStages, stage);
+        if (stage == numStages - 1)
+            sectionQuality *= quality;
+
+        sections[(size_t) stage] = design(sectionQuality);
+    }
+
+    return sections;
+}
+
+static const CoefficientArray biquadIdentity { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+static const SvfCoefficientArray svfIdentity { 0.0, 0.0, 1.0, 0.0, 0.0 };
+
+// K = tan(pi * f / fs), the bilinear prewarp every design below is written in.
+static float getFastPrewarp(double sampleRate, float frequency)
+{
+    auto nyquistSafe = juce::jmin(static_cast<double>(frequency), 0.49 * sampleRate);
+    return juce::dsp::FastMathApproximations::tan(static_cast<float>(juce::MathConstants<double>::pi * nyquistSafe / sampleRate));
+}
+
+// sqrt(decibelsToGain(dB)) = exp(dB * ln(10) / 40), the amplitude A of the peak and shelf designs.
+static float getFastAmplitude(float gainInDecibels)
+{
+    return juce::dsp::FastMathApproximations::exp(gainInDecibels * 0.0575646273f);
+}
+
+// The fast designs are JUCE's formulas multiplied through by 1 + K^2, which turns every
+// sin and cos of the cutoff into a polynomial in K. The bank divides by a0 anyway.
+static CoefficientArray makeFastHighPass(double sampleRate, float frequency, float quality)
+{
+    auto k = getFastPrewarp(sampleRate, frequency);
+    auto kk = k * k;
+    auto kOverQ = k / quality;
+    return { 1.f, -2.f, 1.f, 1.f + kOverQ + kk, 2.f * (kk - 1.f), 1.f - kOverQ + kk };
+}
+
+static CoefficientArray makeFastLowPass(double sampleRate, float frequency, float quality)
+{
+    auto k = getFastPrewarp(sampleRate, frequency);
+    auto kk = k * k;
+    auto kOverQ = k / quality;
+    return { kk, 2.f * kk, kk, 1.f + kOverQ + kk, 2.f * (kk - 1.f), 1.f - kOverQ + kk };
+}
+
+static CoefficientArray makeFastPeakFilter(double sampleRate, float frequency, float quality, float gainInDecibels)
+{
+    auto k = getFastPrewarp(sampleRate, juce::jmax(frequency, 2.f));
+    auto a = getFastAmplitude(gainInDecibels);
+    auto kk = k * k;
+    auto kOverQ = k / quality;
+    return { 1.f + kk + kOverQ * a, 2.f * (kk - 1.f), 1.f + kk - kOverQ * a,
+             1.f + kk + kOverQ / a, 2.f * (kk - 1.f), 1.f + kk - kOverQ / a };
+}
+
+static CoefficientArray makeFastLowShelf(double sampleRate, float frequency, float quality, float gainInDecibels)
+{
+    auto k = getFastPrewarp(sampleRate, juce::jmax(frequency, 2.f));
+    auto a = getFastAmplitude(gainInDecibels);
+    auto kk = k * k;
+    auto beta = k * std::sqrt(a) / quality;
+    return { a * (1.f + a * kk + beta), 2.f * a * (a * kk - 1.f), a * (1.f + a * kk - beta),
+             a + kk + beta, 2.f * (kk - a), a + kk - beta };
+}
+
+static CoefficientArray makeFastHighShelf(double sampleRate, float frequency, float quality, float gainInDecibels)
+{
+    auto k = getFastPrewarp(sampleRate, juce::jmax(frequency, 2.f));
+    auto a = getFastAmplitude(gainInDecibels);
+    auto kk = k * k;
+    auto beta = k * std::sqrt(a) / quality;
+    return { a * (a + kk + beta), 2.f * a * (kk - a), a * (a + kk - beta),
+             1.f + a * kk + beta, 2.f * (a * kk - 1.f), 1.f + a * kk - beta };
+}
+
+CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    return makeButterworthSections(chainSettings.lowCutSlope, chainSettings.lowCutQuality, biquadIdentity, [&](double quality)
+    {
+        if (accuracy == DesignAccuracy::fast)
+            return makeFastHighPass(sampleRate, chainSettings.lowCutFreq, quality);
+
+        return juce::dsp::IIR::ArrayCoefficients<double>::makeHighPass(sampleRate, chainSettings.lowCutFreq, quality);
+    });
+}
+
+CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    return makeButterworthSections(chainSettings.highCutSlope, chainSettings.highCutQuality, biquadIdentity, [&](double quality)
+    {
+        if (accuracy == DesignAccuracy::fast)
+            return makeFastLowPass(sampleRate, chainSettings.highCutFreq, quality);
+
+        return juce::dsp::IIR::ArrayCoefficients<double>::makeLowPass(sampleRate, chainSettings.highCutFreq, quality);
+    });
+}
+
+static double getPrewarp(double sampleRate, float frequency, DesignAccuracy accuracy)
+{
+    if (accuracy == DesignAccuracy::fast)
+        return getFastPrewarp(sampleRate, frequency);
+
+    auto nyquistSafe = juce::jmin(static_cast<double>(frequency), 0.49 * sampleRate);
+    return std::tan(juce::MathConstants<double>::pi * nyquistSafe / sampleRate);
+}
+
+static double getAmplitude(float gainInDecibels, DesignAccuracy accuracy)
+{
+    if (accuracy == DesignAccuracy::fast)
+        return getFastAmplitude(gainInDecibels);
+
+    return std::sqrt(juce::Decibels::decibelsToGain(static_cast<double>(gainInDecibels)));
+}
+
+// H(s) = (b2 s^2 + b1 s + b0) / (a2 s^2 + a1 s + a0), with s in radians per sample, or
+// relative to the centre frequency when w0 = 1. These are the RBJ cookbook prototypes.
+struct AnalogPrototype
+{
+    double b0, b1, b2, a0, a1, a2;
+
+    double getPower(double w) const noexcept
+    {
+        auto numeratorReal = b0 - b2 * w * w, numeratorImag = b1 * w;
+        auto denominatorReal = a0 - a2 * w * w, denominatorImag = a1 * w;
+        return (numeratorReal * numeratorReal + numeratorImag * numeratorImag)
+             / (denominatorReal * denominatorReal + denominatorImag * denominatorImag);
+    }
+};
+
+static AnalogPrototype makePeakPrototype(double w0, double quality, double a)
+{
+    return { w0 * w0, w0 * a / quality, 1.0, w0 * w0, w0 / (a * quality), 1.0 };
+}
+
+static AnalogPrototype makeLowShelfPrototype(double w0, double quality, double a)
+{
+    auto beta = w0 * std::sqrt(a) / quality;
+    return { a * a * w0 * w0, a * beta, a, w0 * w0, beta, a };
+}
+
+static AnalogPrototype makeHighShelfPrototype(double w0, double quality, double a)
+{
+    auto beta = w0 * std::sqrt(a) / quality;
+    return { a * w0 * w0, a * beta, a * a, a * w0 * w0, beta, 1.0 };
+}
+
+// Vicanek's matched second order design ("Matched Second Order Digital Filters", 2016).
+// The poles are the impulse invariant images of the prototype's, and the zeros are
+// solved so |H|^2 equals the prototype's at DC, at w0 and at Nyquist. Everything is
+// written in |H|^2 = sum Bi phi_i / sum Ai phi_i with phi1 = sin^2(w / 2), phi0 = 1 - phi1
+// and phi2 = 4 phi0 phi1. There is no fast variant; glides use the same formulas.
+static CoefficientArray makeMatchedSection(const AnalogPrototype& prototype, double w0)
+{
+    auto pi = juce::MathConstants<double>::pi;
+    auto naturalFrequency = juce::jmin(std::sqrt(prototype.a0 / prototype.a2), 0.98 * pi);
+    auto damping = prototype.a1 / (2.0 * std::sqrt(prototype.a0 * prototype.a2));
+    auto decay = std::exp(-damping * naturalFrequency);
+    auto a1 = damping <= 1.0 ? -2.0 * decay * std::cos(naturalFrequency * std::sqrt(1.0 - damping * damping))
+                             : -2.0 * decay * std::cosh(naturalFrequency * std::sqrt(damping * damping - 1.0));
+    auto a2 = decay * decay;
+
+    auto A0 = (1.0 + a1 + a2) * (1.0 + a1 + a2);
+    auto A1 = (1.0 - a1 + a2) * (1.0 - a1 + a2);
+    auto A2 = -4.0 * a2;
+
+    auto phi1 = std::pow(std::sin(0.5 * w0), 2.0);
+    auto phi0 = 1.0 - phi1;
+    auto phi2 = 4.0 * phi0 * phi1;
+
+    auto B0 = A0 * prototype.getPower(0.0);
+    auto B1 = A1 * prototype.getPower(pi);
+    auto B2 = (prototype.getPower(w0) * (A0 * phi0 + A1 * phi1 + A2 * phi2) - B0 * phi0 - B1 * phi1) / phi2;
+
+    auto root0 = std::sqrt(B0);
+    auto root1 = std::sqrt(B1);
+    auto w = 0.5 * (root0 + root1);
+    auto b0 = 0.5 * (w + std::sqrt(juce::jmax(w * w + B2, 0.0)));
+    return { b0, 0.5 * (root0 - root1), w - b0, 1.0, a1, a2 };
+}
+
+static double getMatchedCentre(double sampleRate, float frequency)
+{
+    auto nyquistSafe = juce::jlimit(2.0, 0.49 * sampleRate, static_cast<double>(frequency));
+    return juce::MathConstants<double>::twoPi * nyquistSafe / sampleRate;
+}
+
+static CoefficientArray makeMatchedPeak(double sampleRate, float frequency, float quality, float gainInDecibels)
+{
+    auto w0 = getMatchedCentre(sampleRate, frequency);
+    return makeMatchedSection(makePeakPrototype(w0, quality, getAmplitude(gainInDecibels, DesignAccuracy::exact)), w0);
+}
+
+static CoefficientArray makeMatchedLowShelf(double sampleRate, float frequency, float quality, float gainInDecibels)
+{
+    auto w0 = getMatchedCentre(sampleRate, frequency);
+    return makeMatchedSection(makeLowShelfPrototype(w0, quality, getAmplitude(gainInDecibels, DesignAccuracy::exact)), w0);
+}
+
+static CoefficientArray makeMatchedHighShelf(double sampleRate, float frequency, float quality, float gainInDecibels)
+{
+    auto w0 = getMatchedCentre(sampleRate, frequency);
+    return makeMatchedSection(makeHighShelfPrototype(w0, quality, getAmplitude(gainInDecibels, DesignAccuracy::exact)), w0);
+}
+
+// The SVF section with the response of any stable biquad. Its denominator fixes g^2 and
+// g k, and the three mixes then follow from the numerator, normalised by a0:
+// m0 = (B0 - B1 + B2) / 4, m2 = (B1 - 2 m0 (g^2 - 1)) / (2 g^2), m1 = (B0 - B2 - 2 m0 g k) / (2 g)
+// with Bi = bi * 4 / (1 - a1 + a2).
+static SvfCoefficientArray biquadToSvf(const CoefficientArray& coefficients)
+{
+    auto a1 = coefficients[4] / coefficients[3];
+    auto a2 = coefficients[5] / coefficients[3];
+    auto scale = 4.0 / ((1.0 - a1 + a2) * coefficients[3]);
+    auto b0 = coefficients[0] * scale, b1 = coefficients[1] * scale, b2 = coefficients[2] * scale;
+
+    auto gg = (1.0 + a1 + a2) / (1.0 - a1 + a2);
+    auto g = std::sqrt(gg);
+    auto gk = 4.0 / (1.0 - a1 + a2) - 1.0 - gg;
+
+    auto m0 = 0.25 * (b0 - b1 + b2);
+    auto m1 = (b0 - b2 - 2.0 * m0 * gk) / (2.0 * g);
+    auto m2 = (b1 - 2.0 * m0 * (gg - 1.0)) / (2.0 * gg);
+    return { g, gk / g, m0, m1, m2 };
+}
+
+// The mixes are Simper's: each SVF section outputs m0 * input + m1 * band-pass +
+// m2 * low-pass, with k = 1 / Q.
+SvfCutCoefficients makeLowCutSvf(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    auto g = getPrewarp(sampleRate, chainSettings.lowCutFreq, accuracy);
+    return makeButterworthSections(chainSettings.lowCutSlope, chainSettings.lowCutQuality, svfIdentity, [g](double quality)
+    {
+        auto k = 1.0 / quality;
+        return SvfCoefficientArray { g, k, 1.0, -k, -1.0 };
+    });
+}
+
+SvfCutCoefficients makeHighCutSvf(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    auto g = getPrewarp(sampleRate, chainSettings.highCutFreq, accuracy);
+    return makeButterworthSections(chainSettings.highCutSlope, chainSettings.highCutQuality, svfIdentity, [g](double quality)
+    {
+        return SvfCoefficientArray { g, 1.0 / quality, 0.0, 0.0, 1.0 };
+    });
+}
+
+const std::array<BandFields, ChainPositions::HighCut + 1> bandFields
+{{
+    { &ChainSettings::lowCutFreq, &ChainSettings::lowCutQuality, nullptr, &ChainSettings::lowCutSlope,
+      &ChainSettings::lowCutRouting, nullptr, nullptr, nullptr, nullptr },
+    { &ChainSettings::lowShelfFreq, &ChainSettings::lowShelfQuality, &ChainSettings::lowShelfGainInDecibels, nullptr,
+      &ChainSettings::lowShelfRouting, &ChainSettings::lowShelfThreshold, &ChainSettings::lowShelfRatio,
+      &ChainSettings::lowShelfAttack, &ChainSettings::lowShelfRelease },
+    { &ChainSettings::peakFreq1, &ChainSettings::peakQuality1, &ChainSettings::peakGainInDecibels1, nullptr,
+      &ChainSettings::peakRouting1, &ChainSettings::peakThreshold1, &ChainSettings::peakRatio1,
+      &ChainSettings::peakAttack1, &ChainSettings::peakRelease1 },
+    { &ChainSettings::peakFreq2, &ChainSettings::peakQuality2, &ChainSettings::peakGainInDecibels2, nullptr,
+      &ChainSettings::peakRouting2, &ChainSettings::peakThreshold2, &ChainSettings::peakRatio2,
+      &ChainSettings::peakAttack2, &ChainSettings::peakRelease2 },
+    { &ChainSettings::peakFreq3, &ChainSettings::peakQuality3, &ChainSettings::peakGainInDecibels3, nullptr,
+      &ChainSettings::peakRouting3, &ChainSettings::peakThreshold3, &ChainSettings::peakRatio3,
+      &ChainSettings::peakAttack3, &ChainSettings::peakRelease3 },
+    { &ChainSettings::highShelfFreq, &ChainSettings::highShelfQuality, &ChainSettings::highShelfGainInDecibels, nullptr,
+      &ChainSettings::highShelfRouting, &ChainSettings::highShelfThreshold, &ChainSettings::highShelfRatio,
+      &ChainSettings::highShelfAttack, &ChainSettings::highShelfRelease },
+    { &ChainSettings::highCutFreq, &ChainSettings::highCutQuality, nullptr, &ChainSettings::highCutSlope,
+      &ChainSettings::highCutRouting, nullptr, nullptr, nullptr, nullptr }
+}};
+
+ChannelRouting getBandRouting(const ChainSettings& chainSettings, ChainPositions position)
+{
+    return chainSettings.*bandFields[(size_t) position].routing;
+}
+
+struct PeakParameters
+{
+    float frequency, quality, gainInDecibels;
+};
+
+static PeakParameters getPeakParameters(const ChainSettings& chainSettings, int peakIndex)
+{
+    switch (peakIndex)
+    {
+        case 1: return { chainSettings.peakFreq1, chainSettings.peakQuality1, chainSettings.peakGainInDecibels1 };
+        case 2: return { chainSettings.peakFreq2, chainSettings.peakQuality2, chainSettings.peakGainInDecibels2 };
+        case 3: return { chainSettings.peakFreq3, chainSettings.peakQuality3, chainSettings.peakGainInDecibels3 };
+        default:
+            jassertfalse; // Invalid peak index
+            return { 1000.f, 1.f, 0.f };
+    }
+}
+
+CoefficientArray makePeakFilter(const ChainSettings& chainSettings, double sampleRate, int peakIndex, DesignAccuracy accuracy)
+{
+    auto peak = getPeakParameters(chainSettings, peakIndex);
+
+    if (chainSettings.bandDesign == BandDesign::matched)
+        return makeMatchedPeak(sampleRate, peak.frequency, peak.quality, peak.gainInDecibels);
+    if (accuracy == DesignAccuracy::fast)
+        return makeFastPeakFilter(sampleRate, peak.frequency, peak.quality, peak.gainInDecibels);
+
+    return juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(sampleRate, peak.frequency, peak.quality,
+                                                                    juce::Decibels::decibelsToGain(peak.gainInDecibels));
+}
+
+CoefficientArray makeLowShelfFilter(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    if (chainSettings.bandDesign == BandDesign::matched)
+        return makeMatchedLowShelf(sampleRate, chainSettings.lowShelfFreq, chainSettings.lowShelfQuality, chainSettings.lowShelfGainInDecibels);
+    if (accuracy == DesignAccuracy::fast)
+        return makeFastLowShelf(sampleRate, chainSettings.lowShelfFreq, chainSettings.lowShelfQuality, chainSettings.lowShelfGainInDecibels);
+
+    return juce::dsp::IIR::ArrayCoefficients<double>::makeLowShelf(sampleRate,
+                                                                  chainSettings.lowShelfFreq,
+                                                                  chainSettings.lowShelfQuality,
+                                                                  juce::Decibels::decibelsToGain(chainSettings.lowShelfGainInDecibels));
+}
+
+CoefficientArray makeHighShelfFilter(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    if (chainSettings.bandDesign == BandDesign::matched)
+        return makeMatchedHighShelf(sampleRate, chainSettings.highShelfFreq, chainSettings.highShelfQuality, chainSettings.highShelfGainInDecibels);
+    if (accuracy == DesignAccuracy::fast)
+        return makeFastHighShelf(sampleRate, chainSettings.highShelfFreq, chainSettings.highShelfQuality, chainSettings.highShelfGainInDecibels);
+
+    return juce::dsp::IIR::ArrayCoefficients<double>::makeHighShelf(sampleRate,
+                                                                   chainSettings.highShelfFreq,
+                                                                   chainSettings.highShelfQuality,
+                                                                   juce::Decibels::decibelsToGain(chainSettings.highShelfGainInDecibels));
+}
+
+SvfCoefficientArray makePeakSvf(const ChainSettings& chainSettings, double sampleRate, int peakIndex, DesignAccuracy accuracy)
+{
+    if (chainSettings.bandDesign == BandDesign::matched)
+        return biquadToSvf(makePeakFilter(chainSettings, sampleRate, peakIndex, accuracy));
+
+    auto peak = getPeakParameters(chainSettings, peakIndex);
+    auto g = getPrewarp(sampleRate, juce::jmax(peak.frequency, 2.f), accuracy);
+    auto a = getAmplitude(peak.gainInDecibels, accuracy);
+    auto k = 1.0 / (peak.quality * a);
+    return { g, k, 1.0, k * (a * a - 1.0), 0.0 };
+}
+
+SvfCoefficientArray makeLowShelfSvf(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    if (chainSettings.bandDesign == BandDesign::matched)
+        return biquadToSvf(makeLowShelfFilter(chainSettings, sampleRate, accuracy));
+
+    auto a = getAmplitude(chainSettings.lowShelfGainInDecibels, accuracy);
+    auto g = getPrewarp(sampleRate, juce::jmax(chainSettings.lowShelfFreq, 2.f), accuracy) / std::sqrt(a);
+    auto k = 1.0 / chainSettings.lowShelfQuality;
+    return { g, k, 1.0, k * (a - 1.0), a * a - 1.0 };
+}
+
+SvfCoefficientArray makeHighShelfSvf(const ChainSettings& chainSettings, double sampleRate, DesignAccuracy accuracy)
+{
+    if (chainSettings.bandDesign == BandDesign::matched)
+        return biquadToSvf(makeHighShelfFilter(chainSettings, sampleRate, accuracy));
+
+    auto a = getAmplitude(chainSettings.highShelfGainInDecibels, accuracy);
+    auto g = getPrewarp(sampleRate, juce::jmax(chainSettings.highShelfFreq, 2.f), accuracy) * std::sqrt(a);
+    auto k = 1.0 / chainSettings.highShelfQuality;
+    return { g, k, a * a, k * (1.0 - a) * a, 1.0 - a * a };
+}
+
+double getMagnitudeForFrequency(const CoefficientArray& coefficients, double frequency, double sampleRate)
+{
+    constexpr std::complex<double> j(0, 1);
+    auto z1 = std::exp(-juce::MathConstants<double>::twoPi * frequency * j / sampleRate);
+    auto z2 = z1 * z1;
+
+    auto numerator = (double) coefficients[0] + (double) coefficients[1] * z1 + (double) coefficients[2] * z2;
+    auto denominator = (double) coefficients[3] + (double) coefficients[4] * z1 + (double) coefficients[5] * z2;
+    return std::abs(numerator / denominator);
+}
+
+double getPrototypeMagnitudeForFrequency(const ChainSettings& chainSettings, ChainPositions band, double frequency)
+{
+    auto design = [frequency](float centre, float quality, float gainInDecibels, auto makePrototype)
+    {
+        auto a = getAmplitude(gainInDecibels, DesignAccuracy::exact);
+        return std::sqrt(makePrototype(1.0, quality, a).getPower(frequency / centre));
+    };
+
+    switch (band)
+    {
+        case LowShelf:
+            return design(chainSettings.lowShelfFreq, chainSettings.lowShelfQuality, chainSettings.lowShelfGainInDecibels,
+                          makeLowShelfPrototype);
+        case Peak1:
+        case Peak2:
+        case Peak3:
+        {
+            auto peak = getPeakParameters(chainSettings, band - Peak1 + 1);
+            return design(peak.frequency, peak.quality, peak.gainInDecibels, makePeakPrototype);
+        }
+        case HighShelf:
+            return design(chainSettings.highShelfFreq, chainSettings.highShelfQuality, chainSettings.highShelfGainInDecibels,
+                          makeHighShelfPrototype);
+        case LowCut:
+        case HighCut:
+        default:
+            jassertfalse; // Only the peak and shelf bands have a prototype here
+            return 1.0;
+    }
+}
+
+// Expands the cascade of active sections into partial fractions over its poles: each
+// pole p_k with residue r_k = B(p_k) / prod_j (1 - p_j / p_k) over the other poles, and
+// the two poles of a section summed back into one real second order section. The
+// expansion is checked against the cascade's response, and rejected when it disagrees or
+// its branches would cancel each other far above the output level.
+static void designParallelForm(FilterSnapshot& snapshot)
+{
+    using Complex = std::complex<double>;
+    constexpr double maxError = 1.0e-6, maxCancellation = 100.0;
+
+    auto& form = snapshot.parallel;
+    form.valid = false;
+
+    std::array<CoefficientArray, NumCascadeSections> normalised {};
+    std::array<Complex, 2 * NumCascadeSections> poles {};
+    std::array<size_t, NumCascadeSections> activeSections {};
+    size_t numActive = 0;
+    auto directGain = 1.0;
+
+    for (size_t section = 0; section < NumCascadeSections; ++section)
+    {
+        const auto& values = snapshot.sections[section];
+        auto a0 = values[3] != 0.0 ? values[3] : 1.0;
+        auto& n = normalised[section];
+        n = { values[0] / a0, values[1] / a0, values[2] / a0, 1.0, values[4] / a0, values[5] / a0 };
+
+        form.active[section] = ! snapshot.bypassed[section] && ! (n[0] == 1.0 && n[1] == n[4] && n[2] == n[5]);
+        form.sections[section] = {};
+
+        if (! form.active[section])
+            continue;
+
+        if (n[5] == 0.0)
+            return;
+
+        auto root = std::sqrt(Complex(n[4] * n[4] - 4.0 * n[5]));
+        poles[2 * numActive] = 0.5 * (-n[4] + root);
+        poles[2 * numActive + 1] = 0.5 * (-n[4] - root);
+        activeSections[numActive++] = section;
+        directGain *= n[2] / n[5];
+    }
+
+    if (numActive == 0)
+        return;
+
+    std::array<Complex, 2 * NumCascadeSections> residues {};
+
+    for (size_t k = 0; k < 2 * numActive; ++k)
+    {
+        auto inverse = 1.0 / poles[k];
+        Complex numerator = 1.0, denominator = 1.0;
+
+        for (size_t i = 0; i < numActive; ++i)
+        {
+            const auto& n = normalised[activeSections[i]];
+            numerator *= n[0] + inverse * (n[1] + inverse * n[2]);
+        }
+
+        for (size_t j = 0; j < 2 * numActive; ++j)
+            if (j != k)
+                denominator *= 1.0 - poles[j] * inverse;
+
+        if (std::abs(denominator) < 1.0e-12)
+            return;
+
+        residues[k] = numerator / denominator;
+    }
+
+    for (size_t i = 0; i < numActive; ++i)
+    {
+        auto r1 = residues[2 * i], r2 = residues[2 * i + 1];
+        auto p1 = poles[2 * i], p2 = poles[2 * i + 1];
+        const auto& n = normalised[activeSections[i]];
+        form.sections[activeSections[i]] = { (r1 + r2).real(), (-(r1 * p2 + r2 * p1)).real(), n[4], n[5] };
+    }
+
+    form.directGain = directGain;
+
+    // DC, then log-spaced up to just below Nyquist.
+    constexpr int numFrequencies = 64;
+    auto nyquist = 0.5 * snapshot.sampleRate;
+    auto peak = 0.0, error = 0.0, branchSum = 0.0;
+
+    for (int index = 0; index < numFrequencies; ++index)
+    {
+        auto frequency = index == 0 ? 0.0
+                                    : 10.0 * std::pow(0.99 * nyquist / 10.0, (double) (index - 1) / (numFrequencies - 2));
+        auto z1 = std::exp(Complex(0.0, -juce::MathConstants<double>::twoPi * frequency / snapshot.sampleRate));
+        auto z2 = z1 * z1;
+        Complex cascade = 1.0, parallel = directGain;
+        auto branches = std::abs(directGain);
+
+        for (size_t i = 0; i < numActive; ++i)
+        {
+            auto section = activeSections[i];
+            const auto& n = normalised[section];
+            const auto& c = form.sections[section];
+            auto denominator = 1.0 + n[4] * z1 + n[5] * z2;
+            auto branch = (c[0] + c[1] * z1) / denominator;
+
+            cascade *= (n[0] + n[1] * z1 + n[2] * z2) / denominator;
+            parallel += branch;
+            branches += std::abs(branch);
+        }
+
+        peak = juce::jmax(peak, std::abs(cascade));
+        error = juce::jmax(error, std::abs(parallel - cascade));
+        branchSum = juce::jmax(branchSum, branches);
+    }
+
+    form.valid = std::isfinite(error) && std::isfinite(branchSum)
+                 && error <= maxError * peak && branchSum <= maxCancellation * peak;
+}
+
+void designSnapshot(FilterSnapshot& snapshot, juce::uint32 dirtyBands, DesignAccuracy accuracy)
+{
+    // The bands are designed with their dynamic gain on top of the parameter's.
+    auto chainSettings = snapshot.settings;
+    for (size_t band = 0; band < bandFields.size(); ++band)
+        if (bandFields[band].gainInDecibels != nullptr)
+            chainSettings.*bandFields[band].gainInDecibels += snapshot.dynamicGainInDecibels[band];
+
+    auto sampleRate = snapshot.sampleRate;
+    auto designSvf = chainSettings.topology == FilterTopology::svf;
+
+    if (dirtyBands & getBandFlag(ChainPositions::LowCut))
+    {
+        auto lowCut = makeLowCutFilter(chainSettings, sampleRate, accuracy);
+        auto lowCutSvf = designSvf ? makeLowCutSvf(chainSettings, sampleRate, accuracy) : SvfCutCoefficients {};
+        for (int stage = 0; stage < 4; ++stage)
+        {
+            snapshot.sections[LowCutSections + stage] = lowCut[(size_t) stage];
+            snapshot.svfSections[LowCutSections + stage] = lowCutSvf[(size_t) stage];
+            snapshot.bypassed[LowCutSections + stage] = stage > chainSettings.lowCutSlope;
+        }
+    }
+
+    if (dirtyBands & getBandFlag(ChainPositions::LowShelf))
+    {
+        snapshot.sections[LowShelfSection] = makeLowShelfFilter(chainSettings, sampleRate, accuracy);
+        if (designSvf)
+            snapshot.svfSections[LowShelfSection] = makeLowShelfSvf(chainSettings, sampleRate, accuracy);
+    }
+
+    for (int peakIndex = 1; peakIndex <= 3; ++peakIndex)
+    {
+        auto position = static_cast<ChainPositions>(ChainPositions::Peak1 + peakIndex - 1);
+        auto section = static_cast<size_t>(Peak1Section + peakIndex - 1);
+
+        if (dirtyBands & getBandFlag(position))
+        {
+            snapshot.sections[section] = makePeakFilter(chainSettings, sampleRate, peakIndex, accuracy);
+            if (designSvf)
+                snapshot.svfSections[section] = makePeakSvf(chainSettings, sampleRate, peakIndex, accuracy);
+        }
+    }
+
+    if (dirtyBands & getBandFlag(ChainPositions::HighShelf))
+    {
+        snapshot.sections[HighShelfSection] = makeHighShelfFilter(chainSettings, sampleRate, accuracy);
+        if (designSvf)
+            snapshot.svfSections[HighShelfSection] = makeHighShelfSvf(chainSettings, sampleRate, accuracy);
+    }
+
+    if (dirtyBands & getBandFlag(ChainPositions::HighCut))
+    {
+        auto highCut = makeHighCutFilter(chainSettings, sampleRate, accuracy);
+        auto highCutSvf = designSvf ? makeHighCutSvf(chainSettings, sampleRate, accuracy) : SvfCutCoefficients {};
+        for (int stage = 0; stage < 4; ++stage)
+        {
+            snapshot.sections[HighCutSections + stage] = highCut[(size_t) stage];
+            snapshot.svfSections[HighCutSections + stage] = highCutSvf[(size_t) stage];
+            snapshot.bypassed[HighCutSections + stage] = stage > chainSettings.highCutSlope;
+        }
+    }
+
+    for (int band = ChainPositions::LowCut; band <= ChainPositions::HighCut; ++band)
+    {
+        auto position = static_cast<ChainPositions>(band);
+        if (dirtyBands & getBandFlag(position))
+        {
+            auto sections = getBandSections(position);
+            for (auto section = sections.getStart(); section < sections.getEnd(); ++section)
+                snapshot.routing[(size_t) section] = getBandRouting(chainSettings, position);
+        }
+    }
+
+    // The expansion is quadratic in the active sections and is checked at 64 frequencies,
+    // too much for the audio thread's control ticks. Fast designs leave the form invalid,
+    // so the banks crossfade to the cascade while a glide or a dynamic band moves, and
+    // back once an exact design arrives.
+    snapshot.parallel.valid = false;
+    if (chainSettings.topology == FilterTopology::parallel && accuracy == DesignAccuracy::exact)
+        designParallelForm(snapshot);
+}
+
+void ChainSettingsSmoother::prepare(double sampleRate)
+{
+    auto controlRate = sampleRate / controlInterval;
+
+    for (auto& band : bands)
+    {
+        band.frequency.reset(controlRate, rampLengthSeconds);
+        band.quality.reset(controlRate, rampLengthSeconds);
+        band.gainInDecibels.reset(controlRate, rampLengthSeconds);
+    }
+}
+
+void ChainSettingsSmoother::setCurrentAndTarget(const ChainSettings& settings)
+{
+    target = settings;
+
+    for (size_t index = 0; index < bands.size(); ++index)
+    {
+        const auto& fields = bandFields[index];
+        bands[index].frequency.setCurrentAndTargetValue(settings.*fields.frequency);
+        bands[index].quality.setCurrentAndTargetValue(settings.*fields.quality);
+        if (fields.gainInDecibels != nullptr)
+            bands[index].gainInDecibels.setCurrentAndTargetValue(settings.*fields.gainInDecibels);
+    }
+}
+
+void ChainSettingsSmoother::setTarget(const ChainSettings& settings)
+{
+    target = settings;
+
+    for (size_t index = 0; index < bands.size(); ++index)
+    {
+        const auto& fields = bandFields[index];
+        bands[index].frequency.setTargetValue(settings.*fields.frequency);
+        bands[index].quality.setTargetValue(settings.*fields.quality);
+        if (fields.gainInDecibels != nullptr)
+            bands[index].gainInDecibels.setTargetValue(settings.*fields.gainInDecibels);
+    }
+}
+
+bool ChainSettingsSmoother::isSmoothing() const noexcept
+{
+    for (const auto& band : bands)
+        if (band.frequency.isSmoothing() || band.quality.isSmoothing() || band.gainInDecibels.isSmoothing())
+            return true;
+
+    return false;
+}
+
+juce::uint32 ChainSettingsSmoother::advance(ChainSettings& settings) noexcept
+{
+    juce::uint32 changedBands = 0;
+
+    for (size_t index = 0; index < bands.size(); ++index)
+    {
+        auto& band = bands[index];
+        const auto& fields = bandFields[index];
+        auto changed = false;
+
+        if (band.frequency.isSmoothing())
+        {
+            settings.*fields.frequency = band.frequency.getNextValue();
+            changed = true;
+        }
+        if (band.quality.isSmoothing())
+        {
+            settings.*fields.quality = band.quality.getNextValue();
+            changed = true;
+        }
+        if (band.gainInDecibels.isSmoothing())
+        {
+            settings.*fields.gainInDecibels = band.gainInDecibels.getNextValue();
+            changed = true;
+        }
+        if (fields.slope != nullptr && settings.*fields.slope != target.*fields.slope)
+        {
+            settings.*fields.slope = target.*fields.slope;
+            changed = true;
+        }
+        if (settings.*fields.routing != target.*fields.routing)
+        {
+            settings.*fields.routing = target.*fields.routing;
+            changed = true;
+        }
+
+        if (changed)
+            changedBands |= getBandFlag(static_cast<ChainPositions>(index));
+    }
+
+    return changedBands;
+}
+
+bool SnapshotGlide::switchesBanks(const ChainSettings& from, const ChainSettings& to) noexcept
+{
+    return from.topology != to.topology
+        || from.phaseMode != to.phaseMode
+        || from.oversamplingOrder != to.oversamplingOrder
+        || from.oversamplingFilter != to.oversamplingFilter;
+}
+
+void SnapshotGlide::clear() noexcept
+{
+    snapshot.sampleRate = 0.0;
+    gliding = false;
+    restartGrid();
+}
+
+void SnapshotGlide::jumpTo(const FilterSnapshot& newSnapshot) noexcept
+{
+    // The control grid runs at the rate the banks run at.
+    if (newSnapshot.sampleRate != snapshot.sampleRate)
+        smoother.prepare(newSnapshot.sampleRate);
+
+    snapshot = newSnapshot;
+    smoother.setCurrentAndTarget(snapshot.settings);
+    gliding = false;
+}
+
+void SnapshotGlide::glideTo(const FilterSnapshot& newTarget) noexcept
+{
+    target = newTarget;
+    smoother.setTarget(target.settings);
+    gliding = true;
+}
+
+bool SnapshotGlide::advance() noexcept
+{
+    if (! gliding)
+        return false;
+
+    if (smoother.isSmoothing())
+    {
+        auto movedBands = smoother.advance(snapshot.settings);
+
+        if (smoother.isSmoothing())
+        {
+            designSnapshot(snapshot, movedBands, DesignAccuracy::fast);
+            return true;
+        }
+    }
+
+    // The glide has arrived, so settle on the exact design of the target.
+    snapshot = target;
+    gliding = false;
+    return true;
+}
+
+void SnapshotGlide::setDynamicGains(const std::array<float, ChainPositions::HighCut + 1>& gains,
+                                    juce::uint32 changedBands) noexcept
+{
+    snapshot.dynamicGainInDecibels = gains;
+    designSnapshot(snapshot, changedBands, DesignAccuracy::fast);
+}
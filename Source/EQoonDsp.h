@@ -0,0 +1,652 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadBank.h"
+#include "SvfBank.h"
+#include "ParallelBank.h"
+#include "ChannelWorkerPool.h"
+
+/*
+    The EQ's DSP without the plug-in around it: the settings, the band designs, the
+    filter banks and the parameter glide. Only uses juce_core, juce_audio_basics and
+    juce_dsp, so both the plug-in and EQoonEngine build on it.
+*/
+
+enum Slope
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+// Which filter structure runs the bands. All realise the same responses; the SVF keeps
+// its behaviour under fast modulation and its precision for low bands at high rates.
+// Parallel runs the biquad cascade as a sum of independent sections side by side in the
+// SIMD lanes, for mono and stereo buses, and keeps the cascade where that can't be done
+// accurately or wouldn't be faster.
+enum class FilterTopology
+{
+    biquad,
+    svf,
+    parallel
+};
+
+// Sample type of the filter state when the host processes in float. Double runs the
+// state in double precision and converts only while interleaving the block in and out.
+enum class FilterPrecision
+{
+    float32,
+    float64
+};
+
+// Minimum phase runs the IIR banks. Linear phase runs a symmetric FIR with the same
+// magnitude response, at the cost of half the kernel length in latency.
+enum class PhaseMode
+{
+    minimum,
+    linear
+};
+
+// How the peak and shelf bands are mapped from their analog prototypes. Bilinear designs
+// are JUCE's, which cramp towards Nyquist. Matched designs keep the poles of the
+// prototype and fit the zeros to its magnitude at DC, the centre frequency and Nyquist,
+// so bands high up at 44.1/48 kHz keep their shape without oversampling.
+enum class BandDesign
+{
+    bilinear,
+    matched
+};
+
+// Half-band filters of the oversampling stages. Minimum latency runs polyphase IIR
+// stages with a few samples of delay; linear phase runs equiripple FIR stages.
+enum class OversamplingFilter
+{
+    minimumLatency,
+    linearPhase
+};
+
+// What the dynamic bands listen to: the main input before the EQ, or the sidechain bus.
+// Without an enabled sidechain they fall back to the main input.
+enum class DetectorSource
+{
+    mainInput,
+    sidechain
+};
+
+struct ChainSettings
+{
+    float peakFreq1 { 0 }, peakGainInDecibels1 { 0 }, peakQuality1 {1.f};
+    float peakFreq2 { 0 }, peakGainInDecibels2 { 0 }, peakQuality2 {1.f};
+    float peakFreq3 { 0 }, peakGainInDecibels3 { 0 }, peakQuality3 {1.f};
+    float lowCutFreq { 0 }, highCutFreq { 0 }, lowCutQuality {1.f}, highCutQuality {1.f};
+    float lowShelfFreq { 0 }, lowShelfGainInDecibels { 0 }, lowShelfQuality {1.f};
+    float highShelfFreq { 0 }, highShelfGainInDecibels { 0 }, highShelfQuality {1.f};
+    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
+    FilterTopology topology { FilterTopology::biquad };
+    FilterPrecision precision { FilterPrecision::float32 };
+    PhaseMode phaseMode { PhaseMode::minimum };
+    BandDesign bandDesign { BandDesign::bilinear };
+    int oversamplingOrder { 0 }; // The bands run at 2^order times the host rate
+    OversamplingFilter oversamplingFilter { OversamplingFilter::minimumLatency };
+    bool parallelChannels { false };
+    // Only stereo buses route; on any other layout every band filters every channel.
+    ChannelRouting lowCutRouting { ChannelRouting::stereo }, lowShelfRouting { ChannelRouting::stereo };
+    ChannelRouting peakRouting1 { ChannelRouting::stereo }, peakRouting2 { ChannelRouting::stereo };
+    ChannelRouting peakRouting3 { ChannelRouting::stereo }, highShelfRouting { ChannelRouting::stereo };
+    ChannelRouting highCutRouting { ChannelRouting::stereo };
+    // Dynamics of the peak and shelf bands, which are static while the ratio is 1.
+    float lowShelfThreshold { 0 }, lowShelfRatio { 1.f }, lowShelfAttack { 10.f }, lowShelfRelease { 150.f };
+    float peakThreshold1 { 0 }, peakRatio1 { 1.f }, peakAttack1 { 10.f }, peakRelease1 { 150.f };
+    float peakThreshold2 { 0 }, peakRatio2 { 1.f }, peakAttack2 { 10.f }, peakRelease2 { 150.f };
+    float peakThreshold3 { 0 }, peakRatio3 { 1.f }, peakAttack3 { 10.f }, peakRelease3 { 150.f };
+    float highShelfThreshold { 0 }, highShelfRatio { 1.f }, highShelfAttack { 10.f }, highShelfRelease { 150.f };
+    DetectorSource detectorSource { DetectorSource::mainInput };
+};
+
+// Bands as the parameters see them; the DSP itself only works on CascadeSections.
+enum ChainPositions
+{
+    LowCut,
+    LowShelf,
+    Peak1,
+    Peak2,
+    Peak3,
+    HighShelf,
+    HighCut
+};
+
+// Index of each band's first biquad in the flat bank the processor runs.
+enum CascadeSections
+{
+    LowCutSections = 0,
+    LowShelfSection = 4,
+    Peak1Section,
+    Peak2Section,
+    Peak3Section,
+    HighShelfSection,
+    HighCutSections,
+    NumCascadeSections = HighCutSections + 4
+};
+
+// The prefix of the band's parameter IDs.
+inline const char* getBandName(ChainPositions position)
+{
+    static const char* const names[] = { "LowCut", "LowShelf", "Peak1", "Peak2", "Peak3", "HighShelf", "HighCut" };
+    return names[position];
+}
+
+ChannelRouting getBandRouting(const ChainSettings& chainSettings, ChainPositions position);
+
+struct BandFields
+{
+    float ChainSettings::* frequency;
+    float ChainSettings::* quality;
+    float ChainSettings::* gainInDecibels;
+    Slope ChainSettings::* slope;
+    ChannelRouting ChainSettings::* routing;
+    // Null for the cuts, which have no dynamics.
+    float ChainSettings::* threshold;
+    float ChainSettings::* ratio;
+    float ChainSettings::* attack;
+    float ChainSettings::* release;
+};
+
+// ChainSettings members of each band, in ChainPositions order.
+extern const std::array<BandFields, ChainPositions::HighCut + 1> bandFields;
+
+// The cascade sections a band occupies, end exclusive.
+inline juce::Range<int> getBandSections(ChainPositions position)
+{
+    switch (position)
+    {
+        case LowCut:    return { LowCutSections, LowShelfSection };
+        case LowShelf:  return { LowShelfSection, Peak1Section };
+        case Peak1:     return { Peak1Section, Peak2Section };
+        case Peak2:     return { Peak2Section, Peak3Section };
+        case Peak3:     return { Peak3Section, HighShelfSection };
+        case HighShelf: return { HighShelfSection, HighCutSections };
+        case HighCut:
+        default:        return { HighCutSections, NumCascadeSections };
+    }
+}
+
+// Designs are kept in double so the double precision banks get them unrounded; the
+// float banks round once when a section is set.
+using CoefficientArray = std::array<double, 6>;
+
+// g, k, m0, m1, m2 of one SvfBank section.
+using SvfCoefficientArray = std::array<double, 5>;
+
+// c0, c1, a1, a2 of one ParallelBank section.
+using ParallelCoefficientArray = std::array<double, 4>;
+
+// The biquad sections as a direct gain plus a sum of parallel sections, one for each
+// active section, in CascadeSections order. Invalid when the expansion is too
+// ill-conditioned to run, e.g. for repeated poles or steep cuts at very low frequencies.
+struct ParallelForm
+{
+    bool valid { false };
+    double directGain { 1.0 };
+    std::array<ParallelCoefficientArray, NumCascadeSections> sections {};
+    std::array<bool, NumCascadeSections> active {};
+};
+
+inline juce::uint32 getBandFlag(ChainPositions position)
+{
+    return 1u << position;
+}
+
+constexpr juce::uint32 allBandFlags = (1u << (ChainPositions::HighCut + 1)) - 1;
+
+// Exact designs use JUCE's reference formulas. Fast ones replace tan() and the dB to gain
+// conversion by JUCE's rational approximations (within a few float ulps over the
+// parameter ranges) and are used for the control-rate updates while parameters glide.
+enum class DesignAccuracy
+{
+    exact,
+    fast
+};
+
+// All designs return raw b0, b1, b2, a0, a1, a2 values so they can be copied into the
+// filter bank without allocating on the audio thread.
+CoefficientArray makePeakFilter(const ChainSettings& chainSettings, double sampleRate, int peakIndex,
+                                DesignAccuracy accuracy = DesignAccuracy::exact);
+CoefficientArray makeLowShelfFilter(const ChainSettings& chainSettings, double sampleRate,
+                                    DesignAccuracy accuracy = DesignAccuracy::exact);
+CoefficientArray makeHighShelfFilter(const ChainSettings& chainSettings, double sampleRate,
+                                     DesignAccuracy accuracy = DesignAccuracy::exact);
+
+double getButterworthSectionQuality(int order, int section);
+
+// One biquad per cascade stage, taken from a Butterworth design of order
+// 2 * (slope + 1). Stages the slope doesn't use are left as identity sections.
+using CutCoefficients = std::array<CoefficientArray, 4>;
+
+CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate,
+                                 DesignAccuracy accuracy = DesignAccuracy::exact);
+CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate,
+                                  DesignAccuracy accuracy = DesignAccuracy::exact);
+
+// The same bands as state-variable sections. Each has exactly the response of the
+// biquad design with the same settings.
+SvfCoefficientArray makePeakSvf(const ChainSettings& chainSettings, double sampleRate, int peakIndex,
+                                DesignAccuracy accuracy = DesignAccuracy::exact);
+SvfCoefficientArray makeLowShelfSvf(const ChainSettings& chainSettings, double sampleRate,
+                                    DesignAccuracy accuracy = DesignAccuracy::exact);
+SvfCoefficientArray makeHighShelfSvf(const ChainSettings& chainSettings, double sampleRate,
+                                     DesignAccuracy accuracy = DesignAccuracy::exact);
+
+using SvfCutCoefficients = std::array<SvfCoefficientArray, 4>;
+
+SvfCutCoefficients makeLowCutSvf(const ChainSettings& chainSettings, double sampleRate,
+                                 DesignAccuracy accuracy = DesignAccuracy::exact);
+SvfCutCoefficients makeHighCutSvf(const ChainSettings& chainSettings, double sampleRate,
+                                  DesignAccuracy accuracy = DesignAccuracy::exact);
+
+double getMagnitudeForFrequency(const CoefficientArray& coefficients, double frequency, double sampleRate);
+
+// Magnitude at frequency of the analog prototype a peak or shelf band approximates,
+// which is what both band designs aim for. Only LowShelf, Peak1..3 and HighShelf.
+double getPrototypeMagnitudeForFrequency(const ChainSettings& chainSettings, ChainPositions band, double frequency);
+
+// A complete, self-consistent design: the parameter values plus every biquad of the
+// bank built from them, in CascadeSections order. The audio thread and the response
+// curve both read it. The biquad sections are always designed, since the curve is drawn
+// from them; the SVF sections and the parallel form only while their topology is selected.
+struct FilterSnapshot
+{
+    juce::uint32 version { 0 };
+    juce::uint32 recallCount { 0 }; // Bumped by each state recall, which crossfades
+    double sampleRate { 0.0 };     // The rate the sections are designed for
+    double hostSampleRate { 0.0 }; // sampleRate divided by the oversampling factor
+    ChainSettings settings;
+    std::array<CoefficientArray, NumCascadeSections> sections {};
+    std::array<SvfCoefficientArray, NumCascadeSections> svfSections {};
+    ParallelForm parallel;
+    std::array<bool, NumCascadeSections> bypassed {};
+    std::array<ChannelRouting, NumCascadeSections> routing {};
+    // Added to each band's gain by its dynamics; only the audio thread's snapshot has any.
+    std::array<float, ChainPositions::HighCut + 1> dynamicGainInDecibels {};
+};
+
+void designSnapshot(FilterSnapshot& snapshot, juce::uint32 dirtyBands,
+                    DesignAccuracy accuracy = DesignAccuracy::exact);
+
+// Every topology at one sample type, for any number of channels. Each group of up to
+// numLanes channels runs in the lanes of one SIMD register through its own banks; every
+// group gets the same sections. Only the banks of the selected topology are kept up to
+// date and run. Routing applies to stereo buses only, which fit one group. Groups whose
+// channels are all idle are skipped.
+//
+// The parallel topology runs a group through its ParallelBank while the snapshot's
+// parallel form is valid, unrouted and takes fewer SIMD operations per sample than the
+// cascade; otherwise through the biquad cascade, which it keeps up to date for that.
+// Only exact designs have a valid form, so glides and moving dynamics run the cascade.
+// Switching between the two crossfades over formFadeSeconds, running both meanwhile.
+template <typename SampleType>
+struct FilterBanks
+{
+    static constexpr size_t numLanes = BiquadBank<SampleType, NumCascadeSections>::numLanes;
+    static constexpr double formFadeSeconds = 0.02;
+
+    struct ChannelGroup
+    {
+        BiquadBank<SampleType, NumCascadeSections> biquads;
+        SvfBank<SampleType, NumCascadeSections> svfs;
+        ParallelBank<SampleType, NumCascadeSections> parallel;
+        size_t numChannels = 0;
+        bool idle = false;
+        bool runsParallel = false;
+        int fadeLength = 0, fadeRemaining = 0;
+    };
+
+    juce::OwnedArray<ChannelGroup> groups;
+    bool routesChannels = false;
+
+    static int getNumGroups(size_t numChannels) noexcept
+    {
+        return (int) ((numChannels + numLanes - 1) / numLanes);
+    }
+
+    // Groups it adds have no sections yet, so apply a snapshot after preparing.
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        auto numGroups = juce::jmax(1, getNumGroups(spec.numChannels));
+        routesChannels = spec.numChannels == 2;
+
+        while (groups.size() < numGroups)
+            groups.add(new ChannelGroup());
+
+        groups.removeLast(groups.size() - numGroups);
+
+        for (int index = 0; index < numGroups; ++index)
+        {
+            auto groupSpec = spec;
+            groupSpec.numChannels = (juce::uint32) juce::jmin(numLanes, spec.numChannels - (size_t) index * numLanes);
+
+            auto& group = *groups.getUnchecked(index);
+            group.numChannels = groupSpec.numChannels;
+            group.biquads.prepare(groupSpec);
+            group.svfs.prepare(groupSpec);
+            group.parallel.prepare(groupSpec);
+        }
+    }
+
+    void reset() noexcept
+    {
+        for (auto* group : groups)
+        {
+            group->biquads.reset();
+            group->svfs.reset();
+            group->parallel.reset();
+        }
+    }
+
+    void apply(const FilterSnapshot& snapshot) noexcept
+    {
+        const auto& form = snapshot.parallel;
+        auto usesParallel = snapshot.settings.topology == FilterTopology::parallel;
+        auto routed = false;
+        size_t numActive = 0;
+
+        for (size_t section = 0; section < NumCascadeSections; ++section)
+        {
+            routed = routed || (routesChannels && snapshot.routing[section] != ChannelRouting::stereo);
+            numActive += form.active[section] ? 1 : 0;
+        }
+
+        for (auto* group : groups)
+        {
+            for (size_t section = 0; section < NumCascadeSections; ++section)
+            {
+                auto routing = routesChannels ? snapshot.routing[section] : ChannelRouting::stereo;
+
+                if (snapshot.settings.topology == FilterTopology::svf)
+                    group->svfs.setSection(section, snapshot.svfSections[section], snapshot.bypassed[section], routing);
+                else
+                    group->biquads.setSection(section, snapshot.sections[section], snapshot.bypassed[section], routing);
+            }
+
+            // The cascade costs one operation per section for all the group's channels;
+            // the sum one per register and a horizontal add for each channel.
+            auto cheaper = group->numChannels * (ParallelBank<SampleType, NumCascadeSections>::getNumRegisters(numActive) + 1)
+                             < numActive;
+            auto runsParallel = usesParallel && form.valid && ! routed && cheaper;
+
+            if (usesParallel && form.valid)
+            {
+                for (size_t section = 0; section < NumCascadeSections; ++section)
+                    group->parallel.setSection(section, form.sections[section], form.active[section]);
+
+                group->parallel.setDirectGain(static_cast<SampleType>(form.directGain));
+            }
+
+            if (runsParallel != group->runsParallel)
+                startFormFade(*group, runsParallel, snapshot.sampleRate);
+        }
+    }
+
+    // Skips the SVF glide towards the sections last applied, and any crossfade between
+    // the parallel form and the cascade.
+    void jumpToTargets() noexcept
+    {
+        for (auto* group : groups)
+        {
+            group->svfs.jumpToTargets();
+            group->fadeRemaining = 0;
+        }
+    }
+
+    // A group goes idle when every one of its channels is, and its state is cleared then,
+    // so it starts again from silence when one of them comes back. Idle groups don't run,
+    // so their SVF tuning jumps to its targets as they go idle and as they come back,
+    // rather than ramping from coefficients that have gone stale.
+    template <typename ChannelPredicate>
+    void updateIdleGroups(size_t numChannels, ChannelPredicate isChannelIdle) noexcept
+    {
+        for (int index = 0; index < groups.size(); ++index)
+        {
+            auto& group = *groups.getUnchecked(index);
+            auto firstChannel = (size_t) index * numLanes;
+            auto idle = firstChannel < numChannels;
+
+            for (auto channel = firstChannel; idle && channel < juce::jmin(firstChannel + numLanes, numChannels); ++channel)
+                idle = isChannelIdle(channel);
+
+            if (idle && ! group.idle)
+            {
+                group.biquads.reset();
+                group.svfs.reset();
+                group.parallel.reset();
+                group.fadeRemaining = 0;
+            }
+
+            if (idle != group.idle)
+                group.svfs.jumpToTargets();
+
+            group.idle = idle;
+        }
+    }
+
+    // Only the groups that run can ramp; idle ones sit on their targets.
+    bool isRamping() const noexcept
+    {
+        for (auto* group : groups)
+            if (! group->idle && group->svfs.isRamping())
+                return true;
+
+        return false;
+    }
+
+    // With a pool, the channel groups are shared out between the calling thread and the
+    // pool's workers.
+    template <typename IOType>
+    void process(const juce::dsp::ProcessContextReplacing<IOType>& context, FilterTopology topology,
+                 ChannelWorkerPool* pool = nullptr) noexcept
+    {
+        const auto& block = context.getOutputBlock();
+        auto numGroups = juce::jmin(getNumGroups(block.getNumChannels()), groups.size());
+
+        auto processGroup = [&](int index)
+        {
+            auto& group = *groups.getUnchecked(index);
+            if (group.idle)
+                return;
+
+            auto firstChannel = (size_t) index * numLanes;
+            auto groupBlock = block.getSubsetChannelBlock(firstChannel, juce::jmin(numLanes, block.getNumChannels() - firstChannel));
+            juce::dsp::ProcessContextReplacing<IOType> groupContext(groupBlock);
+            groupContext.isBypassed = context.isBypassed;
+
+            if (topology == FilterTopology::svf)
+                group.svfs.process(groupContext);
+            else if (topology == FilterTopology::parallel)
+                processParallelTopology(group, groupContext);
+            else
+                group.biquads.process(groupContext);
+        };
+
+        if (pool != nullptr && numGroups > 1)
+        {
+            pool->run(numGroups, processGroup);
+            return;
+        }
+
+        for (int index = 0; index < numGroups; ++index)
+            processGroup(index);
+    }
+
+    // The engine that isn't running starts from silence, which the fade covers. A switch
+    // back during a fade reverses it from where it is, with both states still current.
+    static void startFormFade(ChannelGroup& group, bool toParallel, double sampleRate) noexcept
+    {
+        auto length = juce::jmax(1, juce::roundToInt(formFadeSeconds * sampleRate));
+
+        if (group.fadeRemaining > 0)
+        {
+            group.fadeRemaining = juce::jmax(1, length - juce::roundToInt((double) group.fadeRemaining * length / group.fadeLength));
+        }
+        else
+        {
+            if (toParallel)
+                group.parallel.reset();
+            else
+                group.biquads.reset();
+
+            group.fadeRemaining = length;
+        }
+
+        group.fadeLength = length;
+        group.runsParallel = toParallel;
+    }
+
+    template <typename IOType>
+    static void processParallelTopology(ChannelGroup& group, const juce::dsp::ProcessContextReplacing<IOType>& context) noexcept
+    {
+        if (group.fadeRemaining == 0 || context.isBypassed)
+        {
+            if (group.runsParallel)
+                group.parallel.process(context);
+            else
+                group.biquads.process(context);
+
+            return;
+        }
+
+        const auto& block = context.getOutputBlock();
+        auto fadeSamples = juce::jmin(block.getNumSamples(), (size_t) group.fadeRemaining);
+        auto fadeBlock = block.getSubBlock(0, fadeSamples);
+
+        // The parallel form's gain, rising towards it or falling away from it.
+        auto step = static_cast<SampleType>(1) / static_cast<SampleType>(group.fadeLength);
+        auto position = static_cast<SampleType>(group.fadeLength - group.fadeRemaining) * step;
+        auto startGain = group.runsParallel ? position : static_cast<SampleType>(1) - position;
+
+        group.parallel.capture(fadeBlock);
+        group.biquads.process(juce::dsp::ProcessContextReplacing<IOType>(fadeBlock));
+        group.parallel.blend(fadeBlock, startGain, group.runsParallel ? step : -step);
+        group.fadeRemaining -= (int) fadeSamples;
+
+        if (fadeSamples < block.getNumSamples())
+        {
+            auto restBlock = block.getSubBlock(fadeSamples);
+            processParallelTopology(group, juce::dsp::ProcessContextReplacing<IOType>(restBlock));
+        }
+    }
+};
+
+/*
+    Glides the continuous parameters of a ChainSettings towards their latest values, one
+    step per control tick. Frequencies and qualities move on a multiplicative ramp so a
+    sweep covers every octave in the same time; gains move linearly in decibels. Slopes
+    and routings are discrete and switch at the next tick.
+*/
+class ChainSettingsSmoother
+{
+public:
+    static constexpr int controlInterval = 32;
+    static constexpr double rampLengthSeconds = 0.02;
+
+    void prepare(double sampleRate);
+
+    void setCurrentAndTarget(const ChainSettings& settings);
+    void setTarget(const ChainSettings& settings);
+
+    bool isSmoothing() const noexcept;
+
+    // Moves every gliding value one tick on, writes it into settings and returns the
+    // ChainPositions flags of the bands that changed.
+    juce::uint32 advance(ChainSettings& settings) noexcept;
+
+private:
+    struct BandSmoother
+    {
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> frequency, quality;
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> gainInDecibels;
+    };
+
+    std::array<BandSmoother, ChainPositions::HighCut + 1> bands;
+    ChainSettings target;
+};
+
+/*
+    The minimum phase path the plug-in and EQoonEngine share: the snapshot their banks
+    run and its glide towards the exact design of newer settings. While it glides, the
+    moving bands are redesigned fast every controlInterval samples, on a grid that keeps
+    its phase whatever the block sizes. Owners apply getSnapshot() to their banks after
+    every call that changes it.
+
+    jumpTo() and glideTo() take exact designs made off the audio thread, so only the fast
+    redesigns of a glide and of the dynamics run on it. Nothing here allocates.
+*/
+class SnapshotGlide
+{
+public:
+    static constexpr int controlInterval = ChainSettingsSmoother::controlInterval;
+
+    // Whether going from one design to the other switches the banks that run, so it
+    // can't glide and the new banks start from silence.
+    static bool switchesBanks(const ChainSettings& from, const ChainSettings& to) noexcept;
+
+    const FilterSnapshot& getSnapshot() const noexcept { return snapshot; }
+    bool isGliding() const noexcept { return gliding; }
+
+    // Forgets the snapshot, so the next design has to be jumped to, and restarts the grid.
+    void clear() noexcept;
+    void restartGrid() noexcept { samplesUntilControlTick = 0; }
+
+    // Runs target from now on. A new sample rate moves the control grid with it.
+    void jumpTo(const FilterSnapshot& target) noexcept;
+
+    // Glides there from the snapshot, which must have the same rate and banks, and
+    // settles on a copy of target once every value has arrived.
+    void glideTo(const FilterSnapshot& target) noexcept;
+
+    // Moves the glide one tick on. Returns true if the snapshot changed.
+    bool advance() noexcept;
+
+    // Redesigns changedBands fast with these dynamic gains on top of their own. They
+    // last until the next jump, or until the glide settles.
+    void setDynamicGains(const std::array<float, ChainPositions::HighCut + 1>& gains,
+                         juce::uint32 changedBands) noexcept;
+
+    int getSamplesUntilTick() const noexcept { return samplesUntilControlTick; }
+
+    // Keeps the grid in step with audio that went by without the banks.
+    void skip(int numSamples) noexcept
+    {
+        samplesUntilControlTick = ((samplesUntilControlTick - numSamples) % controlInterval + controlInterval) % controlInterval;
+    }
+
+    // Runs numSamples at the banks' rate through processPart(start, length), in parts of
+    // at most maxLength, calling onTick(start) first on every grid point. Parts only end
+    // on the grid while the glide runs or splitsOnGrid() returns true.
+    template <typename TickFunction, typename SplitFunction, typename PartFunction>
+    void process(int numSamples, int maxLength, TickFunction&& onTick, SplitFunction&& splitsOnGrid,
+                 PartFunction&& processPart)
+    {
+        for (int start = 0; start < numSamples;)
+        {
+            if (samplesUntilControlTick == 0)
+            {
+                onTick(start);
+                samplesUntilControlTick = controlInterval;
+            }
+
+            auto length = juce::jmin(numSamples - start, maxLength);
+            if (gliding || splitsOnGrid())
+                length = juce::jmin(length, samplesUntilControlTick);
+
+            processPart(start, length);
+            start += length;
+            skip(length);
+        }
+    }
+
+private:
+    ChainSettingsSmoother smoother;
+    FilterSnapshot snapshot, target;
+    bool gliding = false;
+    int samplesUntilControlTick = 0;
+};
@@ -0,0 +1,101 @@
+#include "EQoonEngine.h"
+
+void EQoonEngine::prepare(double newSampleRate, int numChannels)
+{
+    numPreparedChannels = juce::jmax(1, numChannels);
+    sampleRate = newSampleRate;
+    banks.prepare({ sampleRate, (juce::uint32) internalBlockSize, (juce::uint32) numPreparedChannels });
+    glide.clear();
+
+    if (hasSettings)
+        jumpToTarget();
+}
+
+void EQoonEngine::reset() noexcept
+{
+    banks.reset();
+    glide.restartGrid();
+}
+
+ChainSettings EQoonEngine::getSupportedSettings(ChainSettings settings) noexcept
+{
+    settings.precision = FilterPrecision::float32;
+    settings.phaseMode = PhaseMode::minimum;
+    settings.oversamplingOrder = 0;
+    settings.parallelChannels = false;
+    return settings;
+}
+
+void EQoonEngine::setSettings(const ChainSettings& newSettings) noexcept
+{
+    auto supportedSettings = getSupportedSettings(newSettings);
+    auto jumps = ! hasSettings || SnapshotGlide::switchesBanks(targetSettings, supportedSettings);
+    targetSettings = supportedSettings;
+    hasSettings = true;
+
+    if (jumps || glide.getSnapshot().sampleRate <= 0.0)
+        jumpToTarget();
+    else
+        glide.glideTo(designTarget());
+}
+
+FilterSnapshot EQoonEngine::designTarget() const noexcept
+{
+    FilterSnapshot target;
+    target.sampleRate = target.hostSampleRate = sampleRate;
+    target.settings = targetSettings;
+    designSnapshot(target, allBandFlags);
+    return target;
+}
+
+// Settles on the exact design of the target at once, from silence if the banks change.
+void EQoonEngine::jumpToTarget() noexcept
+{
+    if (sampleRate <= 0.0)
+        return;
+
+    if (SnapshotGlide::switchesBanks(glide.getSnapshot().settings, targetSettings))
+        banks.reset();
+
+    glide.jumpTo(designTarget());
+    banks.apply(glide.getSnapshot());
+    banks.jumpToTargets();
+}
+
+void EQoonEngine::process(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert(numChannels <= numPreparedChannels);
+
+    // Passes the audio through until there is something to design.
+    if (! hasSettings || glide.getSnapshot().sampleRate <= 0.0)
+        return;
+
+    juce::dsp::AudioBlock<float> block(channels, (size_t) juce::jmin(numChannels, numPreparedChannels),
+                                       (size_t) numSamples);
+
+    // As in the plug-in, pieces only end on the grid while something glides.
+    glide.process(numSamples, internalBlockSize,
+                  [this](int)
+                  {
+                      if (glide.advance())
+                          banks.apply(glide.getSnapshot());
+                  },
+                  [this] { return banks.isRamping(); },
+                  [this, &block](int start, int length)
+                  {
+                      auto subBlock = block.getSubBlock((size_t) start, (size_t) length);
+                      juce::dsp::ProcessContextReplacing<float> context(subBlock);
+                      banks.process(context, glide.getSnapshot().settings.topology);
+                  });
+}
+
+size_t EQoonEngine::getMemoryFootprint() const noexcept
+{
+    // Each group's biquad and SVF banks interleave into an aligned scratch block, and its
+    // parallel bank keeps a copy of the input for crossfades.
+    constexpr auto scratchBytes = internalBlockSize * numLanes * sizeof(float);
+    constexpr auto groupHeapBytes = 2 * (scratchBytes + SIMDType::SIMDRegisterSize) + scratchBytes;
+
+    auto numGroups = (size_t) banks.groups.size();
+    return sizeof(*this) + numGroups * (sizeof(FilterBanks<float>::ChannelGroup) + sizeof(void*) + groupHeapBytes);
+}
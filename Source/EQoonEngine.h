@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQoonDsp.h"
+
+/*
+    The EQ as a plain object, for running many streams outside a plug-in host: no
+    parameters, editor, threads or locks, just settings in and samples through. Built
+    into the EQoonCore static library with juce_core, juce_audio_basics and juce_dsp.
+
+    Runs the minimum phase bands in float at the stream's own rate, with any topology,
+    band design and (on stereo streams) routing. The plug-in-only settings are ignored:
+    linear phase, oversampling, 64-bit filter state, parallel channels and the dynamics,
+    which need a sidechain and per-block detectors. New settings glide through the same
+    SnapshotGlide as the plug-in's parameters, on the same 32-sample control grid.
+
+    One engine per stream, each used by one thread at a time; nothing is shared between
+    engines, so any number can run side by side. Only prepare() allocates.
+
+    Memory per engine, after prepare(), is getMemoryFootprint(). The glide keeps two
+    filter snapshots, the running one and its target (about 2 kB each), and the
+    smoother (under 1 kB); each group of up to numLanes channels adds its three banks
+    with their SIMD state (about 6 kB) and a scratch block of internalBlockSize frames
+    for each of them (3 kB). With 128-bit SIMD (SSE, NEON) that comes to about 14 kB for
+    a mono or stereo stream and 23 kB for 5.1; AVX builds hold 8 channels to a group at
+    about 22 kB.
+*/
+class EQoonEngine
+{
+public:
+    using SIMDType = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t numLanes = FilterBanks<float>::numLanes;
+
+    // Longer process() calls run in pieces of this many samples, which keeps the
+    // scratch blocks, and so the engine, small.
+    static constexpr int internalBlockSize = 64;
+
+    void prepare(double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    // The bands glide to the new settings over 20 ms, or jump there the first time and
+    // when the topology changes. Every band's frequency and quality must be in its
+    // parameter's range; until the first call, process() passes the audio through.
+    // Designs the target exactly, so process() only runs the glide's fast redesigns.
+    // Call between process() calls, on the same thread; it doesn't allocate.
+    void setSettings(const ChainSettings& newSettings) noexcept;
+    const ChainSettings& getSettings() const noexcept { return targetSettings; }
+
+    // Filters numChannels channels of numSamples each in place. numChannels may be less
+    // than prepared, never more.
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+    // Bytes held by this engine, itself and its heap blocks.
+    size_t getMemoryFootprint() const noexcept;
+
+private:
+    FilterBanks<float> banks;
+    SnapshotGlide glide;
+    ChainSettings targetSettings;
+    double sampleRate = 0.0;
+    bool hasSettings = false;
+    int numPreparedChannels = 0;
+
+    static ChainSettings getSupportedSettings(ChainSettings settings) noexcept;
+    FilterSnapshot designTarget() const noexcept;
+    void jumpToTarget() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQoonEngine)
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Which channels of a stereo pair a section filters. Mid and side run on M = (L + R) / 2
+// and S = (L - R) / 2 in the first two lanes; the other lanes pass through untouched.
+enum class ChannelRouting
+{
+    stereo,
+    left,
+    right,
+    mid,
+    side
+};
+
+inline bool routesMidSide(ChannelRouting routing) noexcept
+{
+    return routing == ChannelRouting::mid || routing == ChannelRouting::side;
+}
+
+/*
+    Aligned scratch holding one block of up to numLanes channels as consecutive
+    SIMDRegister frames, so a filter can run every channel in the lanes of one register.
+    Shared by the filter banks, which interleave the block, run their sections over the
+    frames and write the result back.
+*/
+template <typename SampleType>
+class InterleavedBuffer
+{
+public:
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t numLanes = SIMDType::SIMDNumElements;
+
+    void allocate(size_t newMaximumBlockSize)
+    {
+        maximumBlockSize = newMaximumBlockSize;
+        data.allocate(maximumBlockSize * numLanes * sizeof(SampleType) + SIMDType::SIMDRegisterSize, true);
+        frames = juce::snapPointerToAlignment(reinterpret_cast<SampleType*>(data.getData()),
+                                              SIMDType::SIMDRegisterSize);
+    }
+
+    size_t getMaximumBlockSize() const noexcept
+    {
+        return maximumBlockSize;
+    }
+
+    SampleType* getFrame(size_t index) noexcept
+    {
+        return frames + index * numLanes;
+    }
+
+    // Lanes without a channel in the block are filled with silence. The block may hold
+    // another sample type, e.g. float I/O around double precision filters; it is
+    // converted on the way in and out. With midSide, a stereo block is encoded to mid
+    // and side as it is copied in, and decoded again by deinterleave().
+    template <typename IOType>
+    void interleave(const juce::dsp::AudioBlock<IOType>& block, bool midSide = false) noexcept
+    {
+        auto numChannels = block.getNumChannels();
+        auto numSamples = block.getNumSamples();
+        jassert(numChannels <= numLanes);
+        jassert(numSamples <= maximumBlockSize);
+
+        if (midSide && numChannels == 2)
+        {
+            auto* left = block.getChannelPointer(0);
+            auto* right = block.getChannelPointer(1);
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto* frame = getFrame(i);
+                auto l = static_cast<SampleType>(left[i]);
+                auto r = static_cast<SampleType>(right[i]);
+                frame[0] = (l + r) * SampleType(0.5);
+                frame[1] = (l - r) * SampleType(0.5);
+
+                for (size_t lane = 2; lane < numLanes; ++lane)
+                    frame[lane] = SampleType();
+            }
+
+            return;
+        }
+
+        for (size_t channel = 0; channel < numLanes; ++channel)
+        {
+            auto* frame = frames + channel;
+
+            if (channel < numChannels)
+            {
+                auto* source = block.getChannelPointer(channel);
+                for (size_t i = 0; i < numSamples; ++i)
+                    frame[i * numLanes] = static_cast<SampleType>(source[i]);
+            }
+            else
+            {
+                for (size_t i = 0; i < numSamples; ++i)
+                    frame[i * numLanes] = SampleType();
+            }
+        }
+    }
+
+    template <typename IOType>
+    void deinterleave(const juce::dsp::AudioBlock<IOType>& block, bool midSide = false) const noexcept
+    {
+        auto numSamples = block.getNumSamples();
+
+        if (midSide && block.getNumChannels() == 2)
+        {
+            auto* left = block.getChannelPointer(0);
+            auto* right = block.getChannelPointer(1);
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const auto* frame = frames + i * numLanes;
+                left[i] = static_cast<IOType>(frame[0] + frame[1]);
+                right[i] = static_cast<IOType>(frame[0] - frame[1]);
+            }
+
+            return;
+        }
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* frame = frames + channel;
+            auto* destination = block.getChannelPointer(channel);
+            for (size_t i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<IOType>(frame[i * numLanes]);
+        }
+    }
+
+    // Switches the first two lanes between left/right and mid/side in place, for a
+    // cascade whose sections change representation part way through.
+    void convertMidSide(size_t numSamples, bool toMidSide) noexcept
+    {
+        auto scale = toMidSide ? SampleType(0.5) : SampleType(1);
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto* frame = getFrame(i);
+            auto a = frame[0], b = frame[1];
+            frame[0] = (a + b) * scale;
+            frame[1] = (a - b) * scale;
+        }
+    }
+
+    // value in the lanes the routing filters, identity in the others.
+    static SIMDType routeLanes(SampleType value, SampleType identity, ChannelRouting routing) noexcept
+    {
+        if (routing == ChannelRouting::stereo)
+            return SIMDType::expand(value);
+
+        auto lanes = SIMDType::expand(identity);
+        lanes.set(routing == ChannelRouting::left || routing == ChannelRouting::mid ? 0 : 1, value);
+        return lanes;
+    }
+
+    // Same threshold and comparison as JUCE_SNAP_TO_ZERO, applied per lane.
+    static SIMDType snapToZero(SIMDType value) noexcept
+    {
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            auto x = value.get(lane);
+            if (! (x < (SampleType) -1.0e-8f || x > (SampleType) 1.0e-8f))
+                value.set(lane, SampleType());
+        }
+
+        return value;
+    }
+
+private:
+    juce::HeapBlock<char> data;
+    SampleType* frames = nullptr;
+    size_t maximumBlockSize = 0;
+};
+
+/*
+    Splits a packed cascade into runs of sections that share one representation of the
+    stereo pair. Left and right sections need left/right, mid and side sections need
+    mid/side, and stereo sections give the same result in either, so they join the run
+    they fall in. The banks encode to mid/side while interleaving and decode while
+    deinterleaving, so only a switch between two runs costs a conversion pass.
+*/
+template <size_t MaxSections>
+class RoutingRuns
+{
+public:
+    void clear() noexcept
+    {
+        numRuns = 0;
+        numSections = 0;
+    }
+
+    // Call once per active section, in cascade order.
+    void add(ChannelRouting routing) noexcept
+    {
+        auto constrained = routing != ChannelRouting::stereo;
+        auto midSide = routesMidSide(routing);
+
+        if (numRuns == 0)
+        {
+            midSides[numRuns++] = midSide;
+            lastRunFixed = constrained;
+        }
+        else if (constrained && ! lastRunFixed)
+        {
+            // Only the first run can still be open: the stereo sections before this one
+            // run in whatever it needs.
+            midSides[numRuns - 1] = midSide;
+            lastRunFixed = true;
+        }
+        else if (constrained && midSide != midSides[numRuns - 1])
+        {
+            midSides[numRuns++] = midSide;
+        }
+
+        ends[numRuns - 1] = ++numSections;
+    }
+
+    size_t size() const noexcept                    { return numRuns; }
+    size_t getEnd(size_t run) const noexcept        { return ends[run]; }
+    bool isMidSide(size_t run) const noexcept       { return midSides[run]; }
+
+private:
+    std::array<size_t, MaxSections> ends {};
+    std::array<bool, MaxSections> midSides {};
+    size_t numRuns = 0, numSections = 0;
+    bool lastRunFixed = false;
+};
@@ -0,0 +1,467 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Linear-phase version of a magnitude response, run as FFT convolution.
+
+    design() samples the magnitude at kernelSize / 2 + 1 evenly spaced frequencies,
+    takes the real inverse FFT of that zero-phase spectrum, centres the result and
+    applies a Blackman window. The kernel is symmetric about kernelSize / 2, so every
+    frequency is delayed by exactly that many samples.
+
+    juce::dsp::Convolution runs the kernel with a non-uniform partition: a short head
+    partition adds no latency of its own and the longer tail partitions keep a 32k tap
+    kernel at 192 kHz affordable. It prepares new kernels on its own background thread
+    and crossfades to them, so design() can be called while audio is running.
+
+    The convolutions are only prepared once the first kernel is loaded: prepare() builds
+    the engine from a kernel loaded before it, so that kernel and the latency reported
+    for it are in place from the first block. Until then process() does nothing.
+
+    juce::dsp::Convolution handles at most two channels, so wider layouts run one
+    convolution per pair of channels, all loaded with the same kernel. Each crossfades
+    on its own, so while a new kernel arrives the pairs may switch a block apart.
+
+    A stereo layout can instead take a 2x2 matrix of responses from designMatrix(), for
+    bands routed to one channel or to mid or side. The diagonal runs as a stereo kernel
+    on the main convolution; the off-diagonal terms, which only mid and side routing
+    produce, run on a second convolution fed the swapped pair and are summed in. That
+    one keeps running for a second after its terms go, while its kernel fades to zero.
+
+    Offline, a kernel that arrives when the background thread gets to it would land at a
+    different point in each render. An immediate load instead prepares a second set of
+    convolutions at once, runs the last kernelSize samples of input through it so it
+    holds the state the running set has, and crossfades to it over a fixed number of
+    samples from the next block. Immediate loads come from the audio thread, between
+    blocks, and only when isFading() is false.
+
+    design() allocates and runs an FFT; call it from a background thread, or between
+    offline blocks, never from a real-time audio callback.
+*/
+class LinearPhaseFir
+{
+public:
+    enum class KernelLoad
+    {
+        background, // Crossfaded in by the convolutions' own thread, while audio runs
+        immediate   // Crossfaded in from the next block, on the audio thread: offline only
+    };
+
+    // About a sixth of a second, which resolves a 20 Hz cut, rounded up to a power of
+    // two for the FFT.
+    static int getKernelSize(double sampleRate) noexcept
+    {
+        return juce::nextPowerOfTwo(juce::jmax(1024, juce::roundToInt(sampleRate / 6.0)));
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        kernelSize = getKernelSize(spec.sampleRate);
+
+        int order = 0;
+        while ((1 << order) < kernelSize)
+            ++order;
+
+        fft = std::make_unique<juce::dsp::FFT>(order);
+        spectrum.assign(2 * (size_t) kernelSize, 0.f);
+        scratch.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+        fadeScratch.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+        history.setSize((int) spec.numChannels, kernelSize);
+        history.clear();
+        historyPosition = 0;
+
+        preparedSpec = spec;
+        numChannels = (int) spec.numChannels;
+        crossHoldLength = (int) spec.sampleRate;
+        fadeLength = juce::jmax(1, juce::roundToInt(immediateFadeSeconds * spec.sampleRate));
+        fadeRemaining = 0;
+
+        if (numChannels == 2)
+            crossScratch.setSize(2, (int) spec.maximumBlockSize);
+
+        active = createSet();
+        standby.reset();
+    }
+
+    void reset() noexcept
+    {
+        fadeRemaining = 0;
+        history.clear();
+        historyPosition = 0;
+
+        if (active == nullptr || ! active->prepared.load())
+            return;
+
+        for (auto* convolution : active->pairs)
+            convolution->reset();
+
+        if (active->cross != nullptr)
+            active->cross->reset();
+    }
+
+    int getNumChannels() const noexcept
+    {
+        return numChannels;
+    }
+
+    // The kernel's own delay plus any the partitioning adds (none for the non-uniform
+    // partition, but the convolution is the authority on that).
+    int getLatencySamples() const noexcept
+    {
+        return kernelSize / 2 + (active == nullptr || active->pairs.isEmpty() ? 0 : active->pairs.getFirst()->getLatency());
+    }
+
+    int getKernelSize() const noexcept
+    {
+        return kernelSize;
+    }
+
+    // True while an immediate load crossfades; the next one has to wait for it.
+    bool isFading() const noexcept
+    {
+        return fadeRemaining > 0;
+    }
+
+    // magnitudeAt(frequency in Hz) returns the linear gain to reproduce there.
+    template <typename MagnitudeFunction>
+    void design(MagnitudeFunction&& magnitudeAt, KernelLoad load = KernelLoad::background)
+    {
+        if (fft == nullptr)
+            return;
+
+        juce::AudioBuffer<float> kernel(1, kernelSize);
+        makeKernel(kernel.getWritePointer(0), [&](int bin) { return magnitudeAt(bin * sampleRate / kernelSize); });
+
+        auto& set = getSetToLoad(load);
+        for (auto* convolution : set.pairs)
+        {
+            juce::AudioBuffer<float> copy(kernel);
+            convolution->loadImpulseResponse(std::move(copy), sampleRate,
+                                             juce::dsp::Convolution::Stereo::no,
+                                             juce::dsp::Convolution::Trim::no,
+                                             juce::dsp::Convolution::Normalise::no);
+        }
+
+        loadCrossKernel(set, nullptr);
+        finishLoad(set);
+    }
+
+    // Stereo layouts only. matrixAt(frequency in Hz) returns { ll, lr, rl, rr }: the
+    // left output is ll * left + lr * right, the right output rl * left + rr * right.
+    template <typename MatrixFunction>
+    void designMatrix(MatrixFunction&& matrixAt, KernelLoad load = KernelLoad::background)
+    {
+        if (fft == nullptr || numChannels != 2)
+            return;
+
+        std::vector<std::array<double, 4>> matrices;
+        auto hasCrossTerms = false;
+
+        for (int bin = 0; bin <= kernelSize / 2; ++bin)
+        {
+            matrices.push_back(matrixAt(bin * sampleRate / kernelSize));
+            hasCrossTerms = hasCrossTerms || matrices.back()[1] != 0.0 || matrices.back()[2] != 0.0;
+        }
+
+        auto entryAt = [&matrices](size_t entry)
+        {
+            return [&matrices, entry](int bin) { return matrices[(size_t) bin][entry]; };
+        };
+
+        auto& set = getSetToLoad(load);
+        juce::AudioBuffer<float> direct(2, kernelSize);
+        makeKernel(direct.getWritePointer(0), entryAt(0));
+        makeKernel(direct.getWritePointer(1), entryAt(3));
+        set.pairs.getFirst()->loadImpulseResponse(std::move(direct), sampleRate,
+                                                  juce::dsp::Convolution::Stereo::yes,
+                                                  juce::dsp::Convolution::Trim::no,
+                                                  juce::dsp::Convolution::Normalise::no);
+
+        if (hasCrossTerms)
+        {
+            // Fed the swapped pair, so its left kernel is lr and its right one rl.
+            juce::AudioBuffer<float> cross(2, kernelSize);
+            makeKernel(cross.getWritePointer(0), entryAt(1));
+            makeKernel(cross.getWritePointer(1), entryAt(2));
+            loadCrossKernel(set, &cross);
+        }
+        else
+        {
+            loadCrossKernel(set, nullptr);
+        }
+
+        finishLoad(set);
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) noexcept
+    {
+        if (active == nullptr || ! active->prepared.load(std::memory_order_acquire))
+            return;
+
+        const auto& block = context.getOutputBlock();
+        auto numSamples = block.getNumSamples();
+        recordHistory(block);
+
+        // The set faded out runs on a copy of the input.
+        juce::dsp::AudioBlock<float> fadeBlock;
+        if (fadeRemaining > 0)
+        {
+            fadeBlock = juce::dsp::AudioBlock<float>(fadeScratch).getSubsetChannelBlock(0, block.getNumChannels())
+                                                                  .getSubBlock(0, numSamples);
+            fadeBlock.copyFrom(block);
+            processSet(*standby, fadeBlock);
+        }
+
+        processSet(*active, block);
+
+        if (fadeRemaining > 0)
+        {
+            auto numFading = juce::jmin((int) numSamples, fadeRemaining);
+            auto fadeStart = fadeLength - fadeRemaining;
+
+            for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            {
+                auto* incoming = block.getChannelPointer(channel);
+                const auto* outgoing = fadeBlock.getChannelPointer(channel);
+
+                for (int i = 0; i < numFading; ++i)
+                {
+                    auto gain = (float) (fadeStart + i + 1) / (float) fadeLength;
+                    incoming[i] = outgoing[i] + gain * (incoming[i] - outgoing[i]);
+                }
+            }
+
+            fadeRemaining -= numFading;
+        }
+    }
+
+    // The convolution only runs in float, so double blocks go through a scratch buffer.
+    void process(const juce::dsp::ProcessContextReplacing<double>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        auto numSamples = (int) block.getNumSamples();
+        juce::dsp::AudioBlock<float> floatBlock(scratch.getArrayOfWritePointers(), block.getNumChannels(),
+                                                (size_t) numSamples);
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* source = block.getChannelPointer(channel);
+            auto* destination = floatBlock.getChannelPointer(channel);
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (float) source[i];
+        }
+
+        process(juce::dsp::ProcessContextReplacing<float>(floatBlock));
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* source = floatBlock.getChannelPointer(channel);
+            auto* destination = block.getChannelPointer(channel);
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (double) source[i];
+        }
+    }
+
+private:
+    static constexpr int headPartitionSize = 256;
+    static constexpr double immediateFadeSeconds = 0.05;
+
+    // The convolutions one kernel runs on: a pair per two channels, and for stereo the
+    // cross terms.
+    struct ConvolutionSet
+    {
+        juce::OwnedArray<juce::dsp::Convolution> pairs;
+        std::unique_ptr<juce::dsp::Convolution> cross;
+
+        // Set once the first kernel is loaded; process() skips the audio until then.
+        std::atomic<bool> prepared { false };
+
+        // Set by the designing thread; the hold is counted down by the audio thread.
+        std::atomic<bool> crossTermsLoaded { false };
+        int crossHoldSamples = 0;
+    };
+
+    std::unique_ptr<ConvolutionSet> active, standby;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> spectrum;
+    juce::AudioBuffer<float> scratch, crossScratch, fadeScratch;
+    juce::dsp::ProcessSpec preparedSpec {};
+    double sampleRate = 0.0;
+    int kernelSize = 0, numChannels = 0, crossHoldLength = 0;
+
+    // Audio thread only: the last kernelSize input samples, which an immediate load runs
+    // through the new set first, and the crossfade to it.
+    juce::AudioBuffer<float> history;
+    int historyPosition = 0, fadeLength = 1, fadeRemaining = 0;
+
+    std::unique_ptr<ConvolutionSet> createSet() const
+    {
+        auto set = std::make_unique<ConvolutionSet>();
+        auto numPairs = juce::jmax(1, (numChannels + 1) / 2);
+
+        for (int pair = 0; pair < numPairs; ++pair)
+            set->pairs.add(new juce::dsp::Convolution(juce::dsp::Convolution::NonUniform { headPartitionSize }));
+
+        if (numChannels == 2)
+        {
+            set->cross = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform { headPartitionSize });
+
+            // An empty convolution passes its input through, so this one starts silent.
+            juce::AudioBuffer<float> silence(2, kernelSize);
+            silence.clear();
+            set->cross->loadImpulseResponse(std::move(silence), sampleRate,
+                                            juce::dsp::Convolution::Stereo::yes,
+                                            juce::dsp::Convolution::Trim::no,
+                                            juce::dsp::Convolution::Normalise::no);
+        }
+
+        return set;
+    }
+
+    // The running set, unless an immediate load can go to a new one.
+    ConvolutionSet& getSetToLoad(KernelLoad load)
+    {
+        if (load == KernelLoad::background || ! active->prepared.load())
+            return *active;
+
+        jassert(! isFading());
+        standby = createSet();
+        return *standby;
+    }
+
+    // Prepares a set after the kernels it starts with are loaded, so juce::dsp::Convolution
+    // builds them at once. A new set then takes over from the running one.
+    void finishLoad(ConvolutionSet& set)
+    {
+        if (! set.prepared.load())
+        {
+            for (int pair = 0; pair < set.pairs.size(); ++pair)
+            {
+                auto pairSpec = preparedSpec;
+                pairSpec.numChannels = (juce::uint32) juce::jlimit(1, 2, numChannels - 2 * pair);
+                set.pairs.getUnchecked(pair)->prepare(pairSpec);
+            }
+
+            if (set.cross != nullptr)
+                set.cross->prepare(preparedSpec);
+
+            set.prepared.store(true, std::memory_order_release);
+        }
+
+        if (&set != standby.get())
+            return;
+
+        // Catches up on the input, oldest first, in blocks no longer than prepared for.
+        auto maxBlockSize = (int) preparedSpec.maximumBlockSize;
+        for (int done = 0; done < kernelSize;)
+        {
+            auto start = (historyPosition + done) % kernelSize;
+            auto length = juce::jmin(maxBlockSize, kernelSize - done, kernelSize - start);
+            auto chunk = juce::dsp::AudioBlock<float>(fadeScratch).getSubBlock(0, (size_t) length);
+            chunk.copyFrom(juce::dsp::AudioBlock<float>(history).getSubBlock((size_t) start, (size_t) length));
+            processSet(set, chunk);
+            done += length;
+        }
+
+        std::swap(active, standby);
+        fadeRemaining = fadeLength;
+    }
+
+    void recordHistory(const juce::dsp::AudioBlock<float>& block) noexcept
+    {
+        auto numSamples = (int) block.getNumSamples();
+        auto numRecorded = juce::jmin((size_t) history.getNumChannels(), block.getNumChannels());
+
+        for (auto from = juce::jmax(0, numSamples - kernelSize); from < numSamples;)
+        {
+            auto length = juce::jmin(numSamples - from, kernelSize - historyPosition);
+
+            for (size_t channel = 0; channel < numRecorded; ++channel)
+                history.copyFrom((int) channel, historyPosition, block.getChannelPointer(channel) + from, length);
+
+            historyPosition = (historyPosition + length) % kernelSize;
+            from += length;
+        }
+    }
+
+    void processSet(ConvolutionSet& set, const juce::dsp::AudioBlock<float>& block) noexcept
+    {
+        auto numSamples = block.getNumSamples();
+        auto hasCross = set.cross != nullptr && block.getNumChannels() == 2;
+
+        if (hasCross)
+        {
+            if (set.crossTermsLoaded.load(std::memory_order_relaxed))
+                set.crossHoldSamples = crossHoldLength;
+            else if (set.crossHoldSamples > 0)
+            {
+                set.crossHoldSamples -= juce::jmin(set.crossHoldSamples, (int) numSamples);
+
+                // It mustn't play stale input when it starts again.
+                if (set.crossHoldSamples == 0)
+                    set.cross->reset();
+            }
+        }
+
+        auto runsCrossTerms = hasCross && set.crossHoldSamples > 0;
+        juce::dsp::AudioBlock<float> crossBlock;
+
+        if (runsCrossTerms)
+        {
+            crossBlock = juce::dsp::AudioBlock<float>(crossScratch).getSubBlock(0, numSamples);
+            crossBlock.getSingleChannelBlock(0).copyFrom(block.getSingleChannelBlock(1));
+            crossBlock.getSingleChannelBlock(1).copyFrom(block.getSingleChannelBlock(0));
+            set.cross->process(juce::dsp::ProcessContextReplacing<float>(crossBlock));
+        }
+
+        for (int pair = 0; pair < set.pairs.size() && (size_t) (2 * pair) < block.getNumChannels(); ++pair)
+        {
+            auto pairBlock = block.getSubsetChannelBlock((size_t) (2 * pair),
+                                                         juce::jmin((size_t) 2, block.getNumChannels() - (size_t) (2 * pair)));
+            set.pairs.getUnchecked(pair)->process(juce::dsp::ProcessContextReplacing<float>(pairBlock));
+        }
+
+        if (runsCrossTerms)
+            block.add(crossBlock);
+    }
+
+    // Turns the zero-phase spectrum given by binMagnitude(bin) into a centred, windowed
+    // kernel.
+    template <typename BinFunction>
+    void makeKernel(float* taps, BinFunction&& binMagnitude)
+    {
+        std::fill(spectrum.begin(), spectrum.end(), 0.f);
+        for (int bin = 0; bin <= kernelSize / 2; ++bin)
+            spectrum[2 * (size_t) bin] = (float) binMagnitude(bin);
+
+        fft->performRealOnlyInverseTransform(spectrum.data());
+
+        for (int i = 0; i < kernelSize; ++i)
+        {
+            auto phase = juce::MathConstants<double>::twoPi * i / kernelSize;
+            auto window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+            taps[i] = (float) (spectrum[(size_t) ((i + kernelSize / 2) % kernelSize)] * window);
+        }
+    }
+
+    // Null loads silence, once, so the hold fades the last cross terms out.
+    void loadCrossKernel(ConvolutionSet& set, juce::AudioBuffer<float>* kernel)
+    {
+        if (set.cross == nullptr || (kernel == nullptr && ! set.crossTermsLoaded.load()))
+            return;
+
+        juce::AudioBuffer<float> taps(2, kernelSize);
+        if (kernel != nullptr)
+            taps.makeCopyOf(*kernel);
+        else
+            taps.clear();
+
+        set.cross->loadImpulseResponse(std::move(taps), sampleRate,
+                                       juce::dsp::Convolution::Stereo::yes,
+                                       juce::dsp::Convolution::Trim::no,
+                                       juce::dsp::Convolution::Normalise::no);
+        set.crossTermsLoaded.store(kernel != nullptr);
+    }
+};
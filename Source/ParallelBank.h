@@ -0,0 +1,270 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "InterleavedBuffer.h"
+
+/*
+    The cascade of a BiquadBank rewritten as a parallel sum: a direct gain plus one
+    section per active cascade section, each keeping that section's poles and taking a
+    first order numerator from the partial fraction expansion of the whole cascade,
+
+        H(z) = direct + sum_k (c0_k + c1_k z^-1) / (1 + a1_k z^-1 + a2_k z^-2)
+
+    The sections don't depend on each other, so they run side by side in the lanes of
+    juce::dsp::SIMDRegisters: the active ones are packed in cascade order, numLanes to a
+    register, and every channel runs on its own through all of them, with one
+    horizontal sum per sample. That puts all the lanes to work on a mono bus, where the
+    cascade fills one lane of a register per section.
+
+    Sections use direct form II, so their state only depends on their poles: a new
+    expansion after any band moves changes each section's numerator and leaves its
+    state valid. As in BiquadBank, a section keeps its state while it stays active and
+    starts from silence when it rejoins.
+
+    capture() and blend() let the owner crossfade between this form and the cascade,
+    which it falls back to when the expansion is ill-conditioned.
+*/
+template <typename SampleType, size_t MaxSections>
+class ParallelBank
+{
+public:
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t numLanes = SIMDType::SIMDNumElements;
+    static constexpr size_t maxRegisters = (MaxSections + numLanes - 1) / numLanes;
+
+    static_assert(maxRegisters <= 8, "Extend the dispatch in processChannel()");
+
+    ParallelBank()
+    {
+        packedIndex.fill(-1);
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels <= numLanes);
+
+        maximumBlockSize = spec.maximumBlockSize;
+        capturedInput.allocate(maximumBlockSize * numLanes, true);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (size_t channel = 0; channel < numLanes; ++channel)
+        {
+            w1[channel].fill(SIMDType::expand(0));
+            w2[channel].fill(SIMDType::expand(0));
+        }
+    }
+
+    // Takes c0, c1, a1, a2 of the parallel section standing in for cascade section index.
+    // The new layout takes effect at the start of the next process() call.
+    template <typename CoefficientType>
+    void setSection(size_t index, const std::array<CoefficientType, 4>& values, bool isActive) noexcept
+    {
+        jassert(index < MaxSections);
+
+        sections[index] = { static_cast<SampleType>(values[0]), static_cast<SampleType>(values[1]),
+                            static_cast<SampleType>(values[2]), static_cast<SampleType>(values[3]), isActive };
+        layoutChanged = true;
+    }
+
+    void setDirectGain(SampleType newDirectGain) noexcept
+    {
+        directGain = newDirectGain;
+    }
+
+    // SIMD registers the sum runs through per channel and sample.
+    static size_t getNumRegisters(size_t numSections) noexcept
+    {
+        return juce::jmax((size_t) 1, (numSections + numLanes - 1) / numLanes);
+    }
+
+    // The context may hold another sample type than the bank.
+    template <typename IOType>
+    void process(const juce::dsp::ProcessContextReplacing<IOType>& context) noexcept
+    {
+        if (layoutChanged)
+            updateLayout();
+
+        if (context.isBypassed)
+            return;
+
+        auto& block = context.getOutputBlock();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* samples = block.getChannelPointer(channel);
+            processChannel<false>(channel, samples, samples, block.getNumSamples(), SampleType(), SampleType());
+        }
+    }
+
+    // Keeps a copy of the block's input, before the cascade filters it in place.
+    template <typename IOType>
+    void capture(const juce::dsp::AudioBlock<IOType>& block) noexcept
+    {
+        jassert(block.getNumSamples() <= maximumBlockSize);
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* source = block.getChannelPointer(channel);
+            auto* destination = capturedInput.get() + channel * maximumBlockSize;
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+                destination[i] = static_cast<SampleType>(source[i]);
+        }
+    }
+
+    // Runs the sum over the captured input and mixes it into the block, which holds the
+    // cascade's output, at a gain going from startGain by gainStep per sample.
+    template <typename IOType>
+    void blend(const juce::dsp::AudioBlock<IOType>& block, SampleType startGain, SampleType gainStep) noexcept
+    {
+        if (layoutChanged)
+            updateLayout();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            processChannel<true>(channel, capturedInput.get() + channel * maximumBlockSize,
+                                 block.getChannelPointer(channel), block.getNumSamples(), startGain, gainStep);
+    }
+
+private:
+    struct Section
+    {
+        SampleType c0, c1, a1, a2;
+        bool active;
+    };
+
+    // Every section as last set, indexed by cascade position.
+    std::array<Section, MaxSections> sections {};
+    std::array<int, MaxSections> packedIndex;
+    bool layoutChanged = true;
+    SampleType directGain { 1 };
+
+    // The active sections only, packed numLanes to a register in cascade order. Lanes
+    // past the last one hold zeros and add nothing to the sum.
+    size_t numRegisters = 1;
+    std::array<SIMDType, maxRegisters> c0, c1, a1, a2;
+    std::array<std::array<SIMDType, maxRegisters>, numLanes> w1, w2;
+
+    juce::HeapBlock<SampleType> capturedInput;
+    size_t maximumBlockSize = 0;
+
+    void updateLayout() noexcept
+    {
+        auto oldW1 = w1, oldW2 = w2;
+        size_t numActive = 0;
+
+        for (size_t reg = 0; reg < maxRegisters; ++reg)
+        {
+            c0[reg] = c1[reg] = a1[reg] = a2[reg] = SIMDType::expand(0);
+
+            for (size_t channel = 0; channel < numLanes; ++channel)
+                w1[channel][reg] = w2[channel][reg] = SIMDType::expand(0);
+        }
+
+        for (size_t index = 0; index < MaxSections; ++index)
+        {
+            const auto& section = sections[index];
+            auto previous = packedIndex[index];
+
+            if (! section.active)
+            {
+                packedIndex[index] = -1;
+                continue;
+            }
+
+            auto k = numActive++;
+            auto reg = k / numLanes, lane = k % numLanes;
+            c0[reg].set(lane, section.c0);
+            c1[reg].set(lane, section.c1);
+            a1[reg].set(lane, section.a1);
+            a2[reg].set(lane, section.a2);
+
+            if (previous >= 0)
+            {
+                auto oldReg = (size_t) previous / numLanes, oldLane = (size_t) previous % numLanes;
+
+                for (size_t channel = 0; channel < numLanes; ++channel)
+                {
+                    w1[channel][reg].set(lane, oldW1[channel][oldReg].get(oldLane));
+                    w2[channel][reg].set(lane, oldW2[channel][oldReg].get(oldLane));
+                }
+            }
+
+            packedIndex[index] = (int) k;
+        }
+
+        numRegisters = getNumRegisters(numActive);
+        layoutChanged = false;
+    }
+
+    template <bool Blend, typename InputType, typename IOType>
+    void processChannel(size_t channel, const InputType* input, IOType* output, size_t numSamples,
+                        SampleType gain, SampleType gainStep) noexcept
+    {
+        switch (numRegisters)
+        {
+            case 1:  runChannel<1, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            case 2:  runChannel<2, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            case 3:  runChannel<3, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            case 4:  runChannel<4, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            case 5:  runChannel<5, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            case 6:  runChannel<6, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            case 7:  runChannel<7, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+            default: runChannel<8, Blend>(channel, input, output, numSamples, gain, gainStep); break;
+        }
+    }
+
+    template <size_t NumRegisters, bool Blend, typename InputType, typename IOType>
+    void runChannel(size_t channel, const InputType* input, IOType* output, size_t numSamples,
+                    SampleType gain, SampleType gainStep) noexcept
+    {
+        constexpr auto numUsed = NumRegisters < maxRegisters ? NumRegisters : maxRegisters;
+        SIMDType cc0[numUsed], cc1[numUsed], ca1[numUsed], ca2[numUsed];
+        SIMDType lw1[numUsed], lw2[numUsed];
+
+        for (size_t reg = 0; reg < numUsed; ++reg)
+        {
+            cc0[reg] = c0[reg];
+            cc1[reg] = c1[reg];
+            ca1[reg] = a1[reg];
+            ca2[reg] = a2[reg];
+            lw1[reg] = w1[channel][reg];
+            lw2[reg] = w2[channel][reg];
+        }
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto x = static_cast<SampleType>(input[i]);
+            auto in = SIMDType::expand(x);
+            auto sum = SIMDType::expand(0);
+
+            for (size_t reg = 0; reg < numUsed; ++reg)
+            {
+                auto w = in - (lw1[reg] * ca1[reg]) - (lw2[reg] * ca2[reg]);
+                sum += (w * cc0[reg]) + (lw1[reg] * cc1[reg]);
+                lw2[reg] = lw1[reg];
+                lw1[reg] = w;
+            }
+
+            auto y = directGain * x + sum.sum();
+
+            if constexpr (Blend)
+            {
+                output[i] = static_cast<IOType>(gain * y + (SampleType(1) - gain) * static_cast<SampleType>(output[i]));
+                gain += gainStep;
+            }
+            else
+            {
+                output[i] = static_cast<IOType>(y);
+            }
+        }
+
+        for (size_t reg = 0; reg < numUsed; ++reg)
+        {
+            w1[channel][reg] = InterleavedBuffer<SampleType>::snapToZero(lw1[reg]);
+            w2[channel][reg] = InterleavedBuffer<SampleType>::snapToZero(lw2[reg]);
+        }
+    }
+};
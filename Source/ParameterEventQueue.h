@@ -0,0 +1,81 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Parameter changes at sample offsets inside the coming block, for hosts and wrappers
+    that hand over automation as points within the block (VST3 parameter queues, CLAP
+    events) rather than one value per block.
+
+    The events live in a fixed array, kept sorted by offset as they're added, so the
+    audio thread never allocates. Events at the same offset stay in the order they were
+    added. Both sides run on the audio thread: the caller fills the queue before
+    processBlock() and the processor drains it between the parts of the block.
+*/
+class ParameterEventQueue
+{
+public:
+    static constexpr int capacity = 512;
+
+    struct Event
+    {
+        juce::AudioProcessorParameter* parameter;
+        int sampleOffset;
+        float value; // Normalised
+    };
+
+    // Returns false, dropping the event, when the queue is full.
+    bool add(juce::AudioProcessorParameter& parameter, int sampleOffset, float value) noexcept
+    {
+        if (numEvents == capacity)
+            return false;
+
+        auto position = numEvents;
+        for (; position > readIndex && events[(size_t) position - 1].sampleOffset > sampleOffset; --position)
+            events[(size_t) position] = events[(size_t) position - 1];
+
+        events[(size_t) position] = { &parameter, juce::jmax(0, sampleOffset), value };
+        ++numEvents;
+        return true;
+    }
+
+    bool hasPending() const noexcept
+    {
+        return readIndex < numEvents;
+    }
+
+    // Offset of the next event; only valid while hasPending().
+    int getNextOffset() const noexcept
+    {
+        return events[(size_t) readIndex].sampleOffset;
+    }
+
+    // Sets every parameter whose events are due by sampleOffset, the way the plug-in
+    // wrappers apply host automation, and returns true if there were any.
+    bool applyUpTo(int sampleOffset) noexcept
+    {
+        auto applied = false;
+
+        for (; hasPending() && getNextOffset() <= sampleOffset; ++readIndex)
+        {
+            const auto& event = events[(size_t) readIndex];
+            event.parameter->setValue(event.value);
+            event.parameter->sendValueChangedMessageToListeners(event.value);
+            applied = true;
+        }
+
+        if (! hasPending())
+            clear();
+
+        return applied;
+    }
+
+    void clear() noexcept
+    {
+        numEvents = readIndex = 0;
+    }
+
+private:
+    std::array<Event, (size_t) capacity> events {};
+    int numEvents = 0, readIndex = 0;
+};
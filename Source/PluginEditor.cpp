@@ -1,233 +1,657 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-ResponseCurveComponent::ResponseCurveComponent(EQoonAudioProcessor& p) : audioProcessor(p)
-{
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
-    {
-        param->addListener(this);
-    }
-    startTimerHz(60);
-}
-
-ResponseCurveComponent::~ResponseCurveComponent()
-{
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
-    {
-        param->removeListener(this);
-    }
-}
-
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
-{
-    parametersChanged.set(true);
-}
-
-void ResponseCurveComponent::timerCallback()
-{
-    if (parametersChanged.compareAndSetBool(false, true))
-    {
-        auto chainSettings = getChainSettings(audioProcessor.apvts);
-
-        auto peakCoefficients1 = makePeakFilter(chainSettings, audioProcessor.getSampleRate(), 1);
-        auto peakCoefficients2 = makePeakFilter(chainSettings, audioProcessor.getSampleRate(), 2);
-        auto peakCoefficients3 = makePeakFilter(chainSettings, audioProcessor.getSampleRate(), 3);
-
-        updateCoefficients(monoChain.get<ChainPositions::Peak1>().coefficients, peakCoefficients1);
-        updateCoefficients(monoChain.get<ChainPositions::Peak2>().coefficients, peakCoefficients2);
-        updateCoefficients(monoChain.get<ChainPositions::Peak3>().coefficients, peakCoefficients3);
-
-        auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-        auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-        
-        updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-        updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
-        
-        auto lowShelfCoefficients = makeLowShelfFilter(chainSettings, audioProcessor.getSampleRate());
-        auto highShelfCoefficients = makeHighShelfFilter(chainSettings, audioProcessor.getSampleRate());
-
-
-        updateCoefficients(monoChain.get<ChainPositions::LowShelf>().coefficients, lowShelfCoefficients);
-        updateCoefficients(monoChain.get<ChainPositions::HighShelf>().coefficients, highShelfCoefficients);
-
-        repaint();
-    }
-}
-
-void ResponseCurveComponent::paint(juce::Graphics& g)
-{
-    using namespace juce;
-    g.fillAll(Colours::black);
-
-    auto responseArea = getLocalBounds();
-    auto w = responseArea.getWidth();
-
-    auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto& lowShelf = monoChain.get<ChainPositions::LowShelf>();
-    auto& peak1 = monoChain.get<ChainPositions::Peak1>();
-    auto& peak2 = monoChain.get<ChainPositions::Peak2>();
-    auto& peak3 = monoChain.get<ChainPositions::Peak3>();
-    auto& highShelf = monoChain.get<ChainPositions::HighShelf>();
-    auto& highcut = monoChain.get<ChainPositions::HighCut>();
-
-    auto sampleRate = audioProcessor.getSampleRate();
-    std::vector<double> mags;
-    mags.resize(w);
-
-    for (int i = 0; i < w; ++i)
-    {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-
-        if (!monoChain.isBypassed<ChainPositions::Peak1>())
-            mag *= peak1.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!monoChain.isBypassed<ChainPositions::Peak2>())
-            mag *= peak2.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!monoChain.isBypassed<ChainPositions::Peak3>())
-            mag *= peak3.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!monoChain.isBypassed<ChainPositions::LowShelf>())
-            mag *= lowShelf.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!monoChain.isBypassed<ChainPositions::HighShelf>())
-            mag *= highShelf.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-        if (!lowcut.isBypassed<0>())
-            mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!lowcut.isBypassed<1>())
-            mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!lowcut.isBypassed<2>())
-            mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!lowcut.isBypassed<3>())
-            mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-        if (!highcut.isBypassed<0>())
-            mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!highcut.isBypassed<1>())
-            mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!highcut.isBypassed<2>())
-            mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!highcut.isBypassed<3>())
-            mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-        mags[i] = Decibels::gainToDecibels(mag);
-    }
-
-    Path responseCurve;
-    const double outputMin = responseArea.getBottom();
-    const double outputMax = responseArea.getY();
-    auto map = [outputMin, outputMax](double input)
-    {
-        return jmap(input, -24.0, 24.0, outputMin, outputMax);
-    };
-
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
-    for (size_t i = 1; i < mags.size(); ++i)
-    {
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
-    }
-
-    g.setColour(Colours::aqua);
-    g.drawRoundedRectangle(responseArea.toFloat(), 4.f, 1.f);
-    g.setColour(Colours::white);
-    g.strokePath(responseCurve, PathStrokeType(2.f));
-}
-
-EQoonAudioProcessorEditor::EQoonAudioProcessorEditor(EQoonAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p),
-      responseCurveComponent(audioProcessor),
-        lowCutFreqSliderAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
-        lowCutSlopeSliderAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
-        lowCutQualitySliderAttachment(audioProcessor.apvts, "LowCut Quality", lowCutQualitySlider),
-        lowShelfFreqSliderAttachment(audioProcessor.apvts, "LowShelf Freq", lowShelfFreqSlider),
-        lowShelfGainSliderAttachment(audioProcessor.apvts, "LowShelf Gain", lowShelfGainSlider),
-        lowShelfQualitySliderAttachment(audioProcessor.apvts, "LowShelf Quality", lowShelfQualitySlider),
-        peakFreqSlider1Attachment(audioProcessor.apvts, "Peak1 Freq", peakFreq1Slider),
-        peakGainSlider1Attachment(audioProcessor.apvts, "Peak1 Gain", peakGain1Slider),
-        peakQualitySlider1Attachment(audioProcessor.apvts, "Peak1 Quality", peakQuality1Slider),
-        peakFreqSlider2Attachment(audioProcessor.apvts, "Peak2 Freq", peakFreq2Slider),
-        peakGainSlider2Attachment(audioProcessor.apvts, "Peak2 Gain", peakGain2Slider),
-        peakQualitySlider2Attachment(audioProcessor.apvts, "Peak2 Quality", peakQuality2Slider),
-        peakFreqSlider3Attachment(audioProcessor.apvts, "Peak3 Freq", peakFreq3Slider),
-        peakGainSlider3Attachment(audioProcessor.apvts, "Peak3 Gain", peakGain3Slider),
-        peakQualitySlider3Attachment(audioProcessor.apvts, "Peak3 Quality", peakQuality3Slider),
-        highShelfFreqSliderAttachment(audioProcessor.apvts, "HighShelf Freq", highShelfFreqSlider),
-        highShelfGainSliderAttachment(audioProcessor.apvts, "HighShelf Gain", highShelfGainSlider),
-        highShelfQualitySliderAttachment(audioProcessor.apvts, "HighShelf Quality", highShelfQualitySlider),
-        highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider),
-        highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider),
-          highCutQualitySliderAttachment(audioProcessor.apvts, "HighCut Quality", highCutQualitySlider)
-{
-    for (auto* comp : getComps())
-    {
-        addAndMakeVisible(comp);
-    }
-    setSize(1000, 600);
-}
-
-EQoonAudioProcessorEditor::~EQoonAudioProcessorEditor()
-{
-}
-
-void EQoonAudioProcessorEditor::paint(juce::Graphics& g)
-{
-    g.fillAll(juce::Colours::black);
-}
-
-void EQoonAudioProcessorEditor::resized()
-{
-    auto bounds = getLocalBounds();
-    auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
-    responseCurveComponent.setBounds(responseArea);
-    
-    auto lowCutArea = bounds.removeFromTop(bounds.getHeight() * 0.143);
-    auto lowShelfArea = bounds.removeFromTop(bounds.getHeight() * 0.167);
-    auto peak1Area = bounds.removeFromTop(bounds.getHeight() * 0.2);
-    auto peak2Area = bounds.removeFromTop(bounds.getHeight() * 0.25);
-    auto peak3Area = bounds.removeFromTop(bounds.getHeight() * 0.33);
-    auto highShelfArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
-    auto highCutArea = bounds;
-    
-    lowCutFreqSlider.setBounds(lowCutArea.removeFromLeft(lowCutArea.getWidth() * 0.33));
-    lowCutSlopeSlider.setBounds(lowCutArea.removeFromLeft(lowCutArea.getWidth() * 0.5));
-    lowCutQualitySlider.setBounds(lowCutArea);
-    
-    lowShelfFreqSlider.setBounds(lowShelfArea.removeFromLeft(lowShelfArea.getWidth() * 0.33));
-    lowShelfGainSlider.setBounds(lowShelfArea.removeFromLeft(lowShelfArea.getWidth() * 0.5));
-    lowShelfQualitySlider.setBounds(lowShelfArea);
-    
-    peakFreq1Slider.setBounds(peak1Area.removeFromLeft(peak1Area.getWidth() * 0.33));
-    peakGain1Slider.setBounds(peak1Area.removeFromLeft(peak1Area.getWidth() * 0.5));
-    peakQuality1Slider.setBounds(peak1Area);
-    
-    peakFreq2Slider.setBounds(peak2Area.removeFromLeft(peak2Area.getWidth() * 0.33));
-    peakGain2Slider.setBounds(peak2Area.removeFromLeft(peak2Area.getWidth() * 0.5));
-    peakQuality2Slider.setBounds(peak2Area);
-    
-    peakFreq3Slider.setBounds(peak3Area.removeFromLeft(peak3Area.getWidth() * 0.33));
-    peakGain3Slider.setBounds(peak3Area.removeFromLeft(peak3Area.getWidth() * 0.5));
-    peakQuality3Slider.setBounds(peak3Area);
-    
-    highShelfFreqSlider.setBounds(highShelfArea.removeFromLeft(highShelfArea.getWidth() * 0.33));
-    highShelfGainSlider.setBounds(highShelfArea.removeFromLeft(highShelfArea.getWidth() * 0.5));
-    highShelfQualitySlider.setBounds(highShelfArea);
-    
-    highCutFreqSlider.setBounds(highCutArea.removeFromLeft(highCutArea.getWidth() * 0.33));
-    highCutSlopeSlider.setBounds(highCutArea.removeFromLeft(highCutArea.getWidth() * 0.5));
-    highCutQualitySlider.setBounds(highCutArea);
-}
-
-
-std::vector<juce::Component*> EQoonAudioProcessorEditor::getComps()
-{
-    return {
-        &peakFreq1Slider, &peakGain1Slider, &peakQuality1Slider,
-        &peakFreq2Slider, &peakGain2Slider, &peakQuality2Slider,
-        &peakFreq3Slider, &peakGain3Slider, &peakQuality3Slider,
-        &lowCutFreqSlider, &highCutFreqSlider, &lowCutSlopeSlider, &highCutSlopeSlider,
-        &lowShelfFreqSlider, &lowShelfGainSlider, &lowShelfQualitySlider,
-        &highShelfFreqSlider, &highShelfGainSlider, &highShelfQualitySlider,
-        &lowCutQualitySlider, &highCutQualitySlider,
-        &responseCurveComponent
-    };
-}
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+ResponseCurveComponent::ResponseCurveComponent(EQoonAudioProcessor& p) : audioProcessor(p)
+{
+    audioProcessor.getDesignThread().addTimeSliceClient(this);
+}
+
+ResponseCurveComponent::~ResponseCurveComponent()
+{
+    audioProcessor.setAnalyzerTaps(false, false);
+
+    // Waits for a running useTimeSlice() to return.
+    audioProcessor.getDesignThread().removeTimeSliceClient(this);
+    cancelPendingUpdate();
+}
+
+void ResponseCurveComponent::setAnalyzerMode(AnalyzerMode mode)
+{
+    analyzerMode.store(mode);
+    audioProcessor.setAnalyzerTaps(mode == AnalyzerMode::preAndPostEq, mode != AnalyzerMode::off);
+}
+
+void ResponseCurveComponent::setAnalyzerSettings(const SpectrumAnalyzer::Settings& settings)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(analyzerSettingsLock);
+        pendingAnalyzerSettings = settings;
+    }
+
+    analyzerSettingsChanged.store(true);
+}
+
+static bool bandDiffers(const FilterSnapshot& a, const FilterSnapshot& b, ChainPositions band)
+{
+    auto sections = getBandSections(band);
+
+    for (auto section = (size_t) sections.getStart(); section < (size_t) sections.getEnd(); ++section)
+        if (a.bypassed[section] != b.bypassed[section] || a.sections[section] != b.sections[section])
+            return true;
+
+    return false;
+}
+
+int ResponseCurveComponent::useTimeSlice()
+{
+    auto width = curveWidth.load();
+    auto height = curveHeight.load();
+    auto version = audioProcessor.getLatestSnapshotVersion();
+    auto curveChanged = width != gridWidth || height != gridHeight || version != snapshot.version;
+
+    // The processor publishes a new version whenever it redesigns, so the curve reuses
+    // its coefficients instead of designing a second copy here.
+    if (version != snapshot.version)
+    {
+        auto latest = audioProcessor.getLatestSnapshot();
+
+        if (latest.sampleRate != snapshot.sampleRate)
+        {
+            gridWidth = -1;
+        }
+        else
+        {
+            for (int band = 0; band <= ChainPositions::HighCut; ++band)
+                if (bandDiffers(latest, snapshot, (ChainPositions) band))
+                    staleBands |= getBandFlag((ChainPositions) band);
+        }
+
+        snapshot = latest;
+    }
+
+    if (width != gridWidth)
+    {
+        gridWidth = width;
+        updateGrid();
+    }
+
+    gridHeight = height;
+
+    if (curveChanged)
+        updateResponsePoints();
+
+    if (updateAnalyzers() || curveChanged)
+        publishFrame();
+
+    return refreshIntervalMs;
+}
+
+void ResponseCurveComponent::handleAsyncUpdate()
+{
+    if (! frames.update())
+        return;
+
+    auto toPath = [](const std::vector<juce::Point<float>>& points, juce::Path& path)
+    {
+        path.clear();
+
+        if (points.empty())
+            return;
+
+        path.preallocateSpace(3 * (int) points.size());
+        path.startNewSubPath(points.front());
+        for (size_t i = 1; i < points.size(); ++i)
+        {
+            path.lineTo(points[i]);
+        }
+    };
+
+    const auto& frame = frames.getReadBuffer();
+    toPath(frame.response, responseCurve);
+    toPath(frame.preEq.level, preEqPaths.level);
+    toPath(frame.preEq.peak, preEqPaths.peak);
+    toPath(frame.postEq.level, postEqPaths.level);
+    toPath(frame.postEq.peak, postEqPaths.peak);
+
+    // The pre-EQ spectrum is drawn filled to the bottom edge.
+    if (! preEqPaths.level.isEmpty())
+    {
+        preEqPaths.level.lineTo((float) frame.preEq.level.back().x, (float) getHeight());
+        preEqPaths.level.lineTo(0.f, (float) getHeight());
+        preEqPaths.level.closeSubPath();
+    }
+
+    repaint();
+}
+
+void ResponseCurveComponent::resized()
+{
+    curveHeight.store(getHeight());
+    curveWidth.store(getWidth());
+    audioProcessor.getDesignThread().moveToFrontOfQueue(this);
+}
+
+void ResponseCurveComponent::updateGrid()
+{
+    auto w = (size_t) juce::jmax(0, gridWidth);
+    cosW.resize(w);
+    cos2W.resize(w);
+    pixelFrequencies.resize(w + 1);
+    totalDecibels.resize(w);
+
+    for (size_t i = 0; i <= w; ++i)
+        pixelFrequencies[i] = juce::mapToLog10(double(i) / double(juce::jmax((size_t) 1, w)), 20.0, 20000.0);
+
+    for (auto& decibels : bandDecibels)
+        decibels.resize(w);
+
+    if (snapshot.sampleRate > 0.0)
+    {
+        for (size_t i = 0; i < w; ++i)
+        {
+            auto omega = juce::MathConstants<double>::twoPi * pixelFrequencies[i] / snapshot.sampleRate;
+            cosW[i] = std::cos(omega);
+            cos2W[i] = std::cos(2.0 * omega);
+        }
+    }
+
+    staleBands = allBandFlags;
+}
+
+void ResponseCurveComponent::updateBand(ChainPositions band)
+{
+    // |H|^2 of a biquad with real coefficients is a ratio of two cosine series:
+    // b0^2 + b1^2 + b2^2 + 2 (b0 b1 + b1 b2) cos w + 2 b0 b2 cos 2w over the same in a.
+    struct PowerTerms
+    {
+        double n0, n1, n2, d0, d1, d2;
+    };
+
+    std::array<PowerTerms, 4> terms;
+    size_t numTerms = 0;
+    auto sections = getBandSections(band);
+
+    if (snapshot.sampleRate > 0.0)
+    {
+        for (auto section = (size_t) sections.getStart(); section < (size_t) sections.getEnd(); ++section)
+        {
+            if (snapshot.bypassed[section])
+                continue;
+
+            const auto& c = snapshot.sections[section];
+            terms[numTerms++] = { c[0] * c[0] + c[1] * c[1] + c[2] * c[2], 2.0 * (c[0] * c[1] + c[1] * c[2]), 2.0 * c[0] * c[2],
+                                  c[3] * c[3] + c[4] * c[4] + c[5] * c[5], 2.0 * (c[3] * c[4] + c[4] * c[5]), 2.0 * c[3] * c[5] };
+        }
+    }
+
+    auto& decibels = bandDecibels[band];
+
+    if (numTerms == 0)
+    {
+        juce::FloatVectorOperations::clear(decibels.data(), (int) decibels.size());
+        return;
+    }
+
+    for (size_t i = 0; i < decibels.size(); ++i)
+    {
+        double numerator = 1.0, denominator = 1.0;
+
+        for (size_t t = 0; t < numTerms; ++t)
+        {
+            numerator *= terms[t].n0 + terms[t].n1 * cosW[i] + terms[t].n2 * cos2W[i];
+            denominator *= terms[t].d0 + terms[t].d1 * cosW[i] + terms[t].d2 * cos2W[i];
+        }
+
+        // Floored at -100 dB like Decibels::gainToDecibels.
+        decibels[i] = (float) (10.0 * std::log10(juce::jmax(numerator / denominator, 1.0e-10)));
+    }
+}
+
+void ResponseCurveComponent::updateResponsePoints()
+{
+    for (int band = 0; band <= ChainPositions::HighCut; ++band)
+        if ((staleBands & getBandFlag((ChainPositions) band)) != 0)
+            updateBand((ChainPositions) band);
+
+    staleBands = 0;
+
+    auto w = (int) totalDecibels.size();
+    auto& points = latestFrame.response;
+    points.resize((size_t) w);
+
+    if (w == 0)
+        return;
+
+    juce::FloatVectorOperations::copy(totalDecibels.data(), bandDecibels.front().data(), w);
+    for (size_t band = 1; band < bandDecibels.size(); ++band)
+        juce::FloatVectorOperations::add(totalDecibels.data(), bandDecibels[band].data(), w);
+
+    const auto outputMin = (float) gridHeight;
+    for (size_t i = 0; i < points.size(); ++i)
+        points[i] = { (float) i, juce::jmap(totalDecibels[i], -24.f, 24.f, outputMin, 0.f) };
+}
+
+bool ResponseCurveComponent::updateAnalyzers()
+{
+    if (analyzerSettingsChanged.exchange(false))
+    {
+        SpectrumAnalyzer::Settings settings;
+        {
+            const juce::SpinLock::ScopedLockType lock(analyzerSettingsLock);
+            settings = pendingAnalyzerSettings;
+        }
+
+        preEqAnalyzer.setSettings(settings);
+        postEqAnalyzer.setSettings(settings);
+        updateSpectrumPoints(preEqAnalyzer, latestFrame.preEq);
+        updateSpectrumPoints(postEqAnalyzer, latestFrame.postEq);
+    }
+
+    auto mode = analyzerMode.load();
+
+    if (mode != runningAnalyzerMode)
+    {
+        // Drop what the taps queued before this mode, and the spectra of taps now off.
+        audioProcessor.getPreEqFifo().discard();
+        audioProcessor.getPostEqFifo().discard();
+        preEqAnalyzer.reset();
+        postEqAnalyzer.reset();
+        latestFrame.preEq = {};
+        latestFrame.postEq = {};
+        runningAnalyzerMode = mode;
+        return true;
+    }
+
+    if (mode == AnalyzerMode::off || snapshot.hostSampleRate <= 0.0)
+        return false;
+
+    auto changed = false;
+
+    if (mode == AnalyzerMode::preAndPostEq && preEqAnalyzer.process(audioProcessor.getPreEqFifo(), snapshot.hostSampleRate))
+    {
+        updateSpectrumPoints(preEqAnalyzer, latestFrame.preEq);
+        changed = true;
+    }
+
+    if (postEqAnalyzer.process(audioProcessor.getPostEqFifo(), snapshot.hostSampleRate))
+    {
+        updateSpectrumPoints(postEqAnalyzer, latestFrame.postEq);
+        changed = true;
+    }
+
+    return changed;
+}
+
+void ResponseCurveComponent::updateSpectrumPoints(const SpectrumAnalyzer& analyzer, SpectrumPoints& points) const
+{
+    toSpectrumPoints(analyzer.getLevel(), analyzer.getFftSize(), points.level);
+
+    if (analyzer.getSettings().peakHold)
+        toSpectrumPoints(analyzer.getPeakLevel(), analyzer.getFftSize(), points.peak);
+    else
+        points.peak.clear();
+}
+
+void ResponseCurveComponent::toSpectrumPoints(const std::vector<float>& decibels, int fftSize,
+                                              std::vector<juce::Point<float>>& points) const
+{
+    auto w = juce::jmax(0, gridWidth);
+    points.resize((size_t) w);
+
+    if (snapshot.hostSampleRate <= 0.0 || decibels.empty())
+    {
+        points.clear();
+        return;
+    }
+
+    // The analyzer taps run at the host rate, whatever rate the bands are designed at.
+    auto binsPerHertz = fftSize / snapshot.hostSampleRate;
+    auto lastBin = (int) decibels.size() - 1;
+
+    for (int i = 0; i < w; ++i)
+    {
+        auto first = pixelFrequencies[(size_t) i] * binsPerHertz;
+        auto last = pixelFrequencies[(size_t) i + 1] * binsPerHertz;
+        float level;
+
+        if (last - first < 1.0)
+        {
+            // Bins wider than the column: interpolate between the two around it.
+            auto bin = juce::jmin((int) first, lastBin);
+            auto next = juce::jmin(bin + 1, lastBin);
+            auto fraction = (float) (first - bin);
+            level = decibels[(size_t) bin] + fraction * (decibels[(size_t) next] - decibels[(size_t) bin]);
+        }
+        else
+        {
+            // Columns covering several bins show the loudest.
+            auto bin = juce::jmin((int) std::ceil(first), lastBin);
+            auto end = juce::jmin((int) last, lastBin);
+            level = decibels[(size_t) bin];
+            while (++bin <= end)
+                level = juce::jmax(level, decibels[(size_t) bin]);
+        }
+
+        auto y = juce::jmap(level, spectrumBottomDecibels, spectrumTopDecibels, (float) gridHeight, 0.f);
+        points[(size_t) i] = { (float) i, juce::jmin(y, (float) gridHeight) };
+    }
+}
+
+void ResponseCurveComponent::publishFrame()
+{
+    auto& frame = frames.getWriteBuffer();
+    frame.response = latestFrame.response;
+    frame.preEq.level = latestFrame.preEq.level;
+    frame.preEq.peak = latestFrame.preEq.peak;
+    frame.postEq.level = latestFrame.postEq.level;
+    frame.postEq.peak = latestFrame.postEq.peak;
+    frames.publish();
+    triggerAsyncUpdate();
+}
+
+void ResponseCurveComponent::renderBackground(float scale)
+{
+    using namespace juce;
+    auto bounds = getLocalBounds().toFloat();
+
+    background = Image(Image::RGB, jmax(1, roundToInt(bounds.getWidth() * scale)),
+                       jmax(1, roundToInt(bounds.getHeight() * scale)), true);
+    backgroundScale = scale;
+
+    Graphics g(background);
+    g.addTransform(AffineTransform::scale(scale));
+    g.fillAll(Colours::black);
+    g.setFont(10.f);
+
+    const float frequencies[] = { 20.f, 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f, 20000.f };
+    for (auto freq : frequencies)
+    {
+        auto x = bounds.getX() + bounds.getWidth() * mapFromLog10(freq, 20.f, 20000.f);
+        g.setColour(Colours::darkgrey);
+        g.drawVerticalLine(roundToInt(x), bounds.getY(), bounds.getBottom());
+
+        auto text = freq >= 1000.f ? String(roundToInt(freq / 1000.f)) + "k" : String(roundToInt(freq));
+        g.setColour(Colours::lightgrey);
+        g.drawText(text, Rectangle<float>(x + 3.f, bounds.getBottom() - 14.f, 40.f, 12.f), Justification::left);
+    }
+
+    for (int gainInDecibels = -24; gainInDecibels <= 24; gainInDecibels += 6)
+    {
+        auto y = jmap((float) gainInDecibels, -24.f, 24.f, bounds.getBottom(), bounds.getY());
+        g.setColour(gainInDecibels == 0 ? Colours::grey : Colours::darkgrey);
+        g.drawHorizontalLine(roundToInt(y), bounds.getX(), bounds.getRight());
+
+        auto text = (gainInDecibels > 0 ? "+" : "") + String(gainInDecibels) + " dB";
+        g.setColour(Colours::lightgrey);
+        g.drawText(text, Rectangle<float>(bounds.getX() + 3.f, y - 13.f, 50.f, 12.f), Justification::left);
+
+        auto spectrumDecibels = jmap((float) gainInDecibels, -24.f, 24.f, spectrumBottomDecibels, spectrumTopDecibels);
+        g.setColour(Colours::grey);
+        g.drawText(String(roundToInt(spectrumDecibels)) + " dBFS", Rectangle<float>(bounds.getRight() - 63.f, y - 13.f, 60.f, 12.f),
+                   Justification::right);
+    }
+
+    g.setColour(Colours::aqua);
+    g.drawRoundedRectangle(bounds, 4.f, 1.f);
+}
+
+void ResponseCurveComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (background.isNull() || scale != backgroundScale
+        || background.getWidth() != jmax(1, roundToInt((float) getWidth() * scale))
+        || background.getHeight() != jmax(1, roundToInt((float) getHeight() * scale)))
+        renderBackground(scale);
+
+    g.drawImage(background, getLocalBounds().toFloat());
+
+    g.setColour(Colours::grey.withAlpha(0.35f));
+    g.fillPath(preEqPaths.level);
+    g.setColour(Colours::grey.withAlpha(0.6f));
+    g.strokePath(preEqPaths.peak, PathStrokeType(1.f));
+    g.setColour(Colours::skyblue.withAlpha(0.8f));
+    g.strokePath(postEqPaths.level, PathStrokeType(1.f));
+    g.setColour(Colours::skyblue.withAlpha(0.4f));
+    g.strokePath(postEqPaths.peak, PathStrokeType(1.f));
+
+    g.setColour(Colours::white);
+    g.strokePath(responseCurve, PathStrokeType(2.f));
+}
+
+LoadMeterComponent::LoadMeterComponent(EQoonAudioProcessor& p) : audioProcessor(p)
+{
+    startTimer(refreshIntervalMs);
+}
+
+void LoadMeterComponent::timerCallback()
+{
+    reading = audioProcessor.getProcessLoad();
+    repaint();
+}
+
+void LoadMeterComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    static const std::array<Colour, ProcessLoadMeter::numStages> stageColours { Colours::orange, Colours::skyblue, Colours::aqua };
+
+    auto bounds = getLocalBounds().toFloat().reduced(4.f, 3.f);
+    g.setFont(10.f);
+
+    // The bar spans the whole budget, each stage's part in its own colour.
+    auto bar = bounds.removeFromLeft(120.f);
+    g.setColour(Colours::darkgrey);
+    g.fillRect(bar);
+
+    auto x = bar.getX();
+    for (size_t stage = 0; stage < ProcessLoadMeter::numStages; ++stage)
+    {
+        auto width = jmin((float) reading.stageLoads[stage] * bar.getWidth(), bar.getRight() - x);
+        g.setColour(stageColours[stage]);
+        g.fillRect(x, bar.getY(), jmax(0.f, width), bar.getHeight());
+        x += jmax(0.f, width);
+    }
+
+    String text;
+    text << "DSP " << String(100.0 * reading.load, 1) << "%, peak " << String(100.0 * reading.peakLoad, 1) << "%";
+
+    for (size_t stage = 0; stage < ProcessLoadMeter::numStages; ++stage)
+        text << "    " << ProcessLoadMeter::getStageName((ProcessLoadMeter::Stage) stage) << " "
+             << String(100.0 * reading.stageLoads[stage], 2) << "%";
+
+    if (reading.numOverruns > 0)
+        text << "    " << String(reading.numOverruns) << " blocks over budget";
+
+    g.setColour(reading.numOverruns > 0 ? Colours::red : Colours::lightgrey);
+    g.drawText(text, bounds.withTrimmedLeft(8.f), Justification::centredLeft);
+}
+
+EQoonAudioProcessorEditor::EQoonAudioProcessorEditor(EQoonAudioProcessor& p)
+    : AudioProcessorEditor(&p), audioProcessor(p),
+      responseCurveComponent(audioProcessor),
+      loadMeterComponent(audioProcessor),
+        lowCutFreqSliderAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
+        lowCutSlopeSliderAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
+        lowCutQualitySliderAttachment(audioProcessor.apvts, "LowCut Quality", lowCutQualitySlider),
+        lowShelfFreqSliderAttachment(audioProcessor.apvts, "LowShelf Freq", lowShelfFreqSlider),
+        lowShelfGainSliderAttachment(audioProcessor.apvts, "LowShelf Gain", lowShelfGainSlider),
+        lowShelfQualitySliderAttachment(audioProcessor.apvts, "LowShelf Quality", lowShelfQualitySlider),
+        peakFreqSlider1Attachment(audioProcessor.apvts, "Peak1 Freq", peakFreq1Slider),
+        peakGainSlider1Attachment(audioProcessor.apvts, "Peak1 Gain", peakGain1Slider),
+        peakQualitySlider1Attachment(audioProcessor.apvts, "Peak1 Quality", peakQuality1Slider),
+        peakFreqSlider2Attachment(audioProcessor.apvts, "Peak2 Freq", peakFreq2Slider),
+        peakGainSlider2Attachment(audioProcessor.apvts, "Peak2 Gain", peakGain2Slider),
+        peakQualitySlider2Attachment(audioProcessor.apvts, "Peak2 Quality", peakQuality2Slider),
+        peakFreqSlider3Attachment(audioProcessor.apvts, "Peak3 Freq", peakFreq3Slider),
+        peakGainSlider3Attachment(audioProcessor.apvts, "Peak3 Gain", peakGain3Slider),
+        peakQualitySlider3Attachment(audioProcessor.apvts, "Peak3 Quality", peakQuality3Slider),
+        highShelfFreqSliderAttachment(audioProcessor.apvts, "HighShelf Freq", highShelfFreqSlider),
+        highShelfGainSliderAttachment(audioProcessor.apvts, "HighShelf Gain", highShelfGainSlider),
+        highShelfQualitySliderAttachment(audioProcessor.apvts, "HighShelf Quality", highShelfQualitySlider),
+        highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider),
+        highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider),
+          highCutQualitySliderAttachment(audioProcessor.apvts, "HighCut Quality", highCutQualitySlider)
+{
+    // The attachments take their items from the boxes, so fill them first.
+    topologyBox.addItemList(audioProcessor.apvts.getParameter("Filter Topology")->getAllValueStrings(), 1);
+    topologyBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Filter Topology", topologyBox);
+    precisionBox.addItemList(audioProcessor.apvts.getParameter("Filter Precision")->getAllValueStrings(), 1);
+    precisionBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Filter Precision", precisionBox);
+    phaseModeBox.addItemList(audioProcessor.apvts.getParameter("Phase Mode")->getAllValueStrings(), 1);
+    phaseModeBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Phase Mode", phaseModeBox);
+    bandDesignBox.addItemList(audioProcessor.apvts.getParameter("Band Design")->getAllValueStrings(), 1);
+    bandDesignBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Band Design", bandDesignBox);
+    oversamplingBox.addItemList(audioProcessor.apvts.getParameter("Oversampling")->getAllValueStrings(), 1);
+    oversamplingBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Oversampling", oversamplingBox);
+    oversamplingFilterBox.addItemList(audioProcessor.apvts.getParameter("Oversampling Filter")->getAllValueStrings(), 1);
+    oversamplingFilterBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Oversampling Filter",
+                                                                                  oversamplingFilterBox);
+    parallelChannelsBox.addItemList(audioProcessor.apvts.getParameter("Parallel Channels")->getAllValueStrings(), 1);
+    parallelChannelsBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Parallel Channels",
+                                                                                parallelChannelsBox);
+
+    for (size_t band = 0; band < routingBoxes.size(); ++band)
+    {
+        auto parameterID = juce::String(getBandName(static_cast<ChainPositions>(band))) + " Routing";
+        routingBoxes[band].addItemList(audioProcessor.apvts.getParameter(parameterID)->getAllValueStrings(), 1);
+        routingBoxAttachments[band] = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, parameterID,
+                                                                                  routingBoxes[band]);
+    }
+
+    detectorSourceBox.addItemList(audioProcessor.apvts.getParameter("Dynamics Detector")->getAllValueStrings(), 1);
+    detectorSourceBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Dynamics Detector",
+                                                                              detectorSourceBox);
+
+    static const char* const dynamicsParameters[] = { " Threshold", " Ratio", " Attack", " Release" };
+
+    for (size_t band = 0; band < numDynamicBands; ++band)
+    {
+        auto name = juce::String(getBandName(static_cast<ChainPositions>(ChainPositions::LowShelf + (int) band)));
+        for (size_t control = 0; control < 4; ++control)
+            dynamicsSliderAttachments[band][control] = std::make_unique<Attachment>(audioProcessor.apvts,
+                                                                                    name + dynamicsParameters[control],
+                                                                                    dynamicsSliders[band][control]);
+    }
+
+    // The analyzer is a view setting, so it lives in the state tree rather than in a
+    // parameter the host would automate.
+    analyzerBox.addItemList({ "Analyzer Off", "Analyzer Post", "Analyzer Pre + Post" }, 1);
+    analyzerBox.onChange = [this]
+    {
+        auto index = analyzerBox.getSelectedItemIndex();
+        audioProcessor.apvts.state.setProperty("AnalyzerMode", index, nullptr);
+        responseCurveComponent.setAnalyzerMode((AnalyzerMode) index);
+    };
+    analyzerBox.setSelectedItemIndex(audioProcessor.apvts.state.getProperty("AnalyzerMode", (int) AnalyzerMode::preAndPostEq));
+
+    for (auto* comp : getComps())
+    {
+        addAndMakeVisible(comp);
+    }
+
+    for (auto& band : dynamicsSliders)
+        for (auto& slider : band)
+            addAndMakeVisible(slider);
+    setSize(1100, 618);
+}
+
+EQoonAudioProcessorEditor::~EQoonAudioProcessorEditor()
+{
+}
+
+void EQoonAudioProcessorEditor::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+}
+
+void EQoonAudioProcessorEditor::resized()
+{
+    auto bounds = getLocalBounds();
+    loadMeterComponent.setBounds(bounds.removeFromBottom(18));
+    auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
+    auto optionsArea = responseArea.removeFromTop(24);
+    topologyBox.setBounds(optionsArea.removeFromRight(120));
+    precisionBox.setBounds(optionsArea.removeFromRight(120));
+    phaseModeBox.setBounds(optionsArea.removeFromRight(140));
+    bandDesignBox.setBounds(optionsArea.removeFromRight(100));
+    oversamplingBox.setBounds(optionsArea.removeFromRight(60));
+    oversamplingFilterBox.setBounds(optionsArea.removeFromRight(140));
+    parallelChannelsBox.setBounds(optionsArea.removeFromRight(120));
+    detectorSourceBox.setBounds(optionsArea.removeFromRight(120));
+    analyzerBox.setBounds(optionsArea.removeFromRight(160));
+    responseCurveComponent.setBounds(responseArea);
+    
+    auto lowCutArea = bounds.removeFromTop(bounds.getHeight() * 0.143);
+    auto lowShelfArea = bounds.removeFromTop(bounds.getHeight() * 0.167);
+    auto peak1Area = bounds.removeFromTop(bounds.getHeight() * 0.2);
+    auto peak2Area = bounds.removeFromTop(bounds.getHeight() * 0.25);
+    auto peak3Area = bounds.removeFromTop(bounds.getHeight() * 0.33);
+    auto highShelfArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
+    auto highCutArea = bounds;
+
+    // In ChainPositions order.
+    std::array<juce::Rectangle<int>*, ChainPositions::HighCut + 1> bandAreas
+        { &lowCutArea, &lowShelfArea, &peak1Area, &peak2Area, &peak3Area, &highShelfArea, &highCutArea };
+
+    for (size_t band = 0; band < bandAreas.size(); ++band)
+        routingBoxes[band].setBounds(bandAreas[band]->removeFromRight(90).withSizeKeepingCentre(80, 24));
+
+    // The dynamics take the right four sevenths of their band's row.
+    for (size_t band = 0; band < numDynamicBands; ++band)
+    {
+        auto& area = *bandAreas[ChainPositions::LowShelf + band];
+        auto dynamicsArea = area.removeFromRight(area.getWidth() * 4 / 7);
+        auto sliderWidth = dynamicsArea.getWidth() / 4;
+
+        for (auto& slider : dynamicsSliders[band])
+            slider.setBounds(dynamicsArea.removeFromLeft(sliderWidth));
+    }
+    
+    lowCutFreqSlider.setBounds(lowCutArea.removeFromLeft(lowCutArea.getWidth() * 0.33));
+    lowCutSlopeSlider.setBounds(lowCutArea.removeFromLeft(lowCutArea.getWidth() * 0.5));
+    lowCutQualitySlider.setBounds(lowCutArea);
+    
+    lowShelfFreqSlider.setBounds(lowShelfArea.removeFromLeft(lowShelfArea.getWidth() * 0.33));
+    lowShelfGainSlider.setBounds(lowShelfArea.removeFromLeft(lowShelfArea.getWidth() * 0.5));
+    lowShelfQualitySlider.setBounds(lowShelfArea);
+    
+    peakFreq1Slider.setBounds(peak1Area.removeFromLeft(peak1Area.getWidth() * 0.33));
+    peakGain1Slider.setBounds(peak1Area.removeFromLeft(peak1Area.getWidth() * 0.5));
+    peakQuality1Slider.setBounds(peak1Area);
+    
+    peakFreq2Slider.setBounds(peak2Area.removeFromLeft(peak2Area.getWidth() * 0.33));
+    peakGain2Slider.setBounds(peak2Area.removeFromLeft(peak2Area.getWidth() * 0.5));
+    peakQuality2Slider.setBounds(peak2Area);
+    
+    peakFreq3Slider.setBounds(peak3Area.removeFromLeft(peak3Area.getWidth() * 0.33));
+    peakGain3Slider.setBounds(peak3Area.removeFromLeft(peak3Area.getWidth() * 0.5));
+    peakQuality3Slider.setBounds(peak3Area);
+    
+    highShelfFreqSlider.setBounds(highShelfArea.removeFromLeft(highShelfArea.getWidth() * 0.33));
+    highShelfGainSlider.setBounds(highShelfArea.removeFromLeft(highShelfArea.getWidth() * 0.5));
+    highShelfQualitySlider.setBounds(highShelfArea);
+    
+    highCutFreqSlider.setBounds(highCutArea.removeFromLeft(highCutArea.getWidth() * 0.33));
+    highCutSlopeSlider.setBounds(highCutArea.removeFromLeft(highCutArea.getWidth() * 0.5));
+    highCutQualitySlider.setBounds(highCutArea);
+}
+
+
+std::vector<juce::Component*> EQoonAudioProcessorEditor::getComps()
+{
+    return {
+        &peakFreq1Slider, &peakGain1Slider, &peakQuality1Slider,
+        &peakFreq2Slider, &peakGain2Slider, &peakQuality2Slider,
+        &peakFreq3Slider, &peakGain3Slider, &peakQuality3Slider,
+        &lowCutFreqSlider, &highCutFreqSlider, &lowCutSlopeSlider, &highCutSlopeSlider,
+        &lowShelfFreqSlider, &lowShelfGainSlider, &lowShelfQualitySlider,
+        &highShelfFreqSlider, &highShelfGainSlider, &highShelfQualitySlider,
+        &lowCutQualitySlider, &highCutQualitySlider,
+        &responseCurveComponent, &loadMeterComponent, &topologyBox, &precisionBox, &phaseModeBox,
+        &bandDesignBox, &oversamplingBox, &oversamplingFilterBox, &parallelChannelsBox, &analyzerBox,
+        &routingBoxes[ChainPositions::LowCut], &routingBoxes[ChainPositions::LowShelf],
+        &routingBoxes[ChainPositions::Peak1], &routingBoxes[ChainPositions::Peak2], &routingBoxes[ChainPositions::Peak3],
+        &routingBoxes[ChainPositions::HighShelf], &routingBoxes[ChainPositions::HighCut], &detectorSourceBox
+    };
+}
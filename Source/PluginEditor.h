@@ -1,66 +1,173 @@
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-struct CustomRotarySlider : juce::Slider
-{
-    CustomRotarySlider() : juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,
-                                        juce::Slider::TextEntryBoxPosition::NoTextBox)
-    {
-    }
-};
-
-struct ResponseCurveComponent : juce::Component,
-                                juce::AudioProcessorParameter::Listener,
-                                juce::Timer
-{
-    ResponseCurveComponent(EQoonAudioProcessor&);
-    ~ResponseCurveComponent();
-
-    void parameterValueChanged(int parameterIndex, float newValue) override;
-    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
-    void timerCallback() override;
-    void paint(juce::Graphics& g) override;
-
-private:
-    EQoonAudioProcessor& audioProcessor;
-    juce::Atomic<bool> parametersChanged{false};
-    MonoChain monoChain;
-};
-
-class EQoonAudioProcessorEditor : public juce::AudioProcessorEditor
-{
-public:
-    EQoonAudioProcessorEditor(EQoonAudioProcessor&);
-    ~EQoonAudioProcessorEditor() override;
-
-    void paint(juce::Graphics&) override;
-    void resized() override;
-
-private:
-    EQoonAudioProcessor& audioProcessor;
-    CustomRotarySlider lowCutFreqSlider, lowCutSlopeSlider, lowCutQualitySlider;
-    CustomRotarySlider lowShelfFreqSlider, lowShelfGainSlider, lowShelfQualitySlider;
-    CustomRotarySlider peakFreq1Slider, peakGain1Slider, peakQuality1Slider;
-    CustomRotarySlider peakFreq2Slider, peakGain2Slider, peakQuality2Slider;
-    CustomRotarySlider peakFreq3Slider, peakGain3Slider, peakQuality3Slider;
-    CustomRotarySlider highShelfFreqSlider, highShelfGainSlider, highShelfQualitySlider;
-    CustomRotarySlider highCutFreqSlider, highCutSlopeSlider, highCutQualitySlider;
-    ResponseCurveComponent responseCurveComponent;
-
-    using APVTS = juce::AudioProcessorValueTreeState;
-    using Attachment = APVTS::SliderAttachment;
-    Attachment lowCutFreqSliderAttachment, lowCutSlopeSliderAttachment, lowCutQualitySliderAttachment;
-    Attachment lowShelfFreqSliderAttachment, lowShelfGainSliderAttachment, lowShelfQualitySliderAttachment;
-    Attachment peakFreqSlider1Attachment, peakGainSlider1Attachment, peakQualitySlider1Attachment;
-    Attachment peakFreqSlider2Attachment, peakGainSlider2Attachment, peakQualitySlider2Attachment;
-    Attachment peakFreqSlider3Attachment, peakGainSlider3Attachment, peakQualitySlider3Attachment;
-    Attachment highShelfFreqSliderAttachment, highShelfGainSliderAttachment, highShelfQualitySliderAttachment;
-    Attachment highCutFreqSliderAttachment, highCutSlopeSliderAttachment, highCutQualitySliderAttachment;
-
-    std::vector<juce::Component*> getComps();
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EQoonAudioProcessorEditor)
-};
-
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "SpectrumAnalyzer.h"
+
+struct CustomRotarySlider : juce::Slider
+{
+    CustomRotarySlider() : juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,
+                                        juce::Slider::TextEntryBoxPosition::NoTextBox)
+    {
+    }
+};
+
+enum class AnalyzerMode
+{
+    off,
+    postEq,
+    preAndPostEq
+};
+
+// Draws the combined magnitude response and the analyzer spectra. Both are evaluated
+// on the processor's design thread, which all EQoon instances share, and handed over
+// as finished point arrays; the message thread only strokes them over a grid image
+// rendered once per size and scale factor.
+//
+// Each band keeps its own dB table on the pixel grid, and a new snapshot only
+// recomputes the bands whose sections changed; the curve is the sum of the tables.
+struct ResponseCurveComponent : juce::Component,
+                                juce::TimeSliceClient,
+                                juce::AsyncUpdater
+{
+    ResponseCurveComponent(EQoonAudioProcessor&);
+    ~ResponseCurveComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    void setAnalyzerMode(AnalyzerMode mode);
+    void setAnalyzerSettings(const SpectrumAnalyzer::Settings& settings);
+
+private:
+    static constexpr int refreshIntervalMs = 16;
+
+    // The spectrum scale: the +24 dB to -24 dB range of the curve shows 0 to -96 dBFS,
+    // so every curve grid line is also a 12 dB spectrum line.
+    static constexpr float spectrumTopDecibels = 0.f, spectrumBottomDecibels = -96.f;
+
+    struct SpectrumPoints
+    {
+        std::vector<juce::Point<float>> level, peak;
+    };
+
+    struct CurveFrame
+    {
+        std::vector<juce::Point<float>> response;
+        SpectrumPoints preEq, postEq;
+    };
+
+    struct SpectrumPaths
+    {
+        juce::Path level, peak;
+    };
+
+    EQoonAudioProcessor& audioProcessor;
+
+    // Written by the message thread, read by the design thread.
+    std::atomic<int> curveWidth { 0 }, curveHeight { 0 };
+    std::atomic<AnalyzerMode> analyzerMode { AnalyzerMode::off };
+    juce::SpinLock analyzerSettingsLock;
+    SpectrumAnalyzer::Settings pendingAnalyzerSettings;
+    std::atomic<bool> analyzerSettingsChanged { false };
+    TripleBuffer<CurveFrame> frames;
+
+    // Design thread only.
+    FilterSnapshot snapshot;
+    int gridWidth = 0, gridHeight = 0;
+    // cos(w) and cos(2w) at each pixel column's frequency, for the snapshot's sample rate,
+    // and the frequencies of the column edges.
+    std::vector<double> cosW, cos2W, pixelFrequencies;
+    std::array<std::vector<float>, ChainPositions::HighCut + 1> bandDecibels;
+    std::vector<float> totalDecibels;
+    juce::uint32 staleBands { allBandFlags };
+    AnalyzerMode runningAnalyzerMode { AnalyzerMode::off };
+    SpectrumAnalyzer preEqAnalyzer, postEqAnalyzer;
+    CurveFrame latestFrame;
+
+    // Message thread only.
+    juce::Path responseCurve;
+    SpectrumPaths preEqPaths, postEqPaths;
+    juce::Image background;
+    float backgroundScale = 0.f;
+
+    int useTimeSlice() override;
+    void handleAsyncUpdate() override;
+
+    void updateGrid();
+    void updateBand(ChainPositions band);
+    void updateResponsePoints();
+    bool updateAnalyzers();
+    void updateSpectrumPoints(const SpectrumAnalyzer& analyzer, SpectrumPoints& points) const;
+    void toSpectrumPoints(const std::vector<float>& decibels, int fftSize, std::vector<juce::Point<float>>& points) const;
+    void publishFrame();
+    void renderBackground(float scale);
+};
+
+// One line under the controls for spotting the expensive instances in a session: the
+// processor's smoothed share of the real-time budget and its peak, with a bar split into
+// the stages in the order listed. Polls the lock-free meter a few times a second.
+struct LoadMeterComponent : juce::Component,
+                            juce::Timer
+{
+    explicit LoadMeterComponent(EQoonAudioProcessor&);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    static constexpr int refreshIntervalMs = 250;
+
+    EQoonAudioProcessor& audioProcessor;
+    ProcessLoadMeter::Reading reading;
+
+    void timerCallback() override;
+};
+
+class EQoonAudioProcessorEditor : public juce::AudioProcessorEditor
+{
+public:
+    EQoonAudioProcessorEditor(EQoonAudioProcessor&);
+    ~EQoonAudioProcessorEditor() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    EQoonAudioProcessor& audioProcessor;
+    CustomRotarySlider lowCutFreqSlider, lowCutSlopeSlider, lowCutQualitySlider;
+    CustomRotarySlider lowShelfFreqSlider, lowShelfGainSlider, lowShelfQualitySlider;
+    CustomRotarySlider peakFreq1Slider, peakGain1Slider, peakQuality1Slider;
+    CustomRotarySlider peakFreq2Slider, peakGain2Slider, peakQuality2Slider;
+    CustomRotarySlider peakFreq3Slider, peakGain3Slider, peakQuality3Slider;
+    CustomRotarySlider highShelfFreqSlider, highShelfGainSlider, highShelfQualitySlider;
+    CustomRotarySlider highCutFreqSlider, highCutSlopeSlider, highCutQualitySlider;
+    ResponseCurveComponent responseCurveComponent;
+    LoadMeterComponent loadMeterComponent;
+    juce::ComboBox topologyBox, precisionBox, phaseModeBox, bandDesignBox, oversamplingBox, oversamplingFilterBox,
+                   parallelChannelsBox, detectorSourceBox, analyzerBox;
+    std::array<juce::ComboBox, ChainPositions::HighCut + 1> routingBoxes;
+
+    // Threshold, ratio, attack and release of LowShelf through HighShelf.
+    static constexpr size_t numDynamicBands = ChainPositions::HighShelf - ChainPositions::LowShelf + 1;
+    std::array<std::array<CustomRotarySlider, 4>, numDynamicBands> dynamicsSliders;
+
+    using APVTS = juce::AudioProcessorValueTreeState;
+    using Attachment = APVTS::SliderAttachment;
+    Attachment lowCutFreqSliderAttachment, lowCutSlopeSliderAttachment, lowCutQualitySliderAttachment;
+    Attachment lowShelfFreqSliderAttachment, lowShelfGainSliderAttachment, lowShelfQualitySliderAttachment;
+    Attachment peakFreqSlider1Attachment, peakGainSlider1Attachment, peakQualitySlider1Attachment;
+    Attachment peakFreqSlider2Attachment, peakGainSlider2Attachment, peakQualitySlider2Attachment;
+    Attachment peakFreqSlider3Attachment, peakGainSlider3Attachment, peakQualitySlider3Attachment;
+    Attachment highShelfFreqSliderAttachment, highShelfGainSliderAttachment, highShelfQualitySliderAttachment;
+    Attachment highCutFreqSliderAttachment, highCutSlopeSliderAttachment, highCutQualitySliderAttachment;
+    std::unique_ptr<APVTS::ComboBoxAttachment> topologyBoxAttachment, precisionBoxAttachment, phaseModeBoxAttachment;
+    std::unique_ptr<APVTS::ComboBoxAttachment> bandDesignBoxAttachment, oversamplingBoxAttachment, oversamplingFilterBoxAttachment;
+    std::unique_ptr<APVTS::ComboBoxAttachment> parallelChannelsBoxAttachment, detectorSourceBoxAttachment;
+    std::array<std::unique_ptr<APVTS::ComboBoxAttachment>, ChainPositions::HighCut + 1> routingBoxAttachments;
+    std::array<std::array<std::unique_ptr<Attachment>, 4>, numDynamicBands> dynamicsSliderAttachments;
+
+    std::vector<juce::Component*> getComps();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EQoonAudioProcessorEditor)
+};
+
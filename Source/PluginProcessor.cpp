@@ -1,388 +1,1354 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-void updateCoefficients(Coefficients& old, const Coefficients& replacements)
-{
-    if (old != replacements)
-        old = replacements;
-}
-
-
-
-EQoonAudioProcessor::EQoonAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       )
-#endif
-{
-}
-
-EQoonAudioProcessor::~EQoonAudioProcessor()
-{
-}
-
-const juce::String EQoonAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool EQoonAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool EQoonAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool EQoonAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double EQoonAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int EQoonAudioProcessor::getNumPrograms()
-{
-    return 1;
-}
-
-int EQoonAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void EQoonAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String EQoonAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void EQoonAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-void EQoonAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
-
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
-
-    updateFilters();
-}
-
-void EQoonAudioProcessor::releaseResources()
-{
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool EQoonAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void EQoonAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-
-    updateFilters();
-
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
-}
-
-bool EQoonAudioProcessor::hasEditor() const
-{
-    return true;
-}
-
-juce::AudioProcessorEditor* EQoonAudioProcessor::createEditor()
-{
-    return new EQoonAudioProcessorEditor (*this);
-}
-
-void EQoonAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
-}
-
-void EQoonAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid())
-    {
-        apvts.replaceState(tree);
-        updateFilters();
-    }
-}
-
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
-{
-    ChainSettings settings;
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.lowCutQuality = apvts.getRawParameterValue("LowCut Quality")->load();
-    settings.lowShelfFreq = apvts.getRawParameterValue("LowShelf Freq")->load();
-    settings.lowShelfGainInDecibels = apvts.getRawParameterValue("LowShelf Gain")->load();
-    settings.lowShelfQuality = apvts.getRawParameterValue("LowShelf Quality")->load();
-    settings.peakFreq1 = apvts.getRawParameterValue("Peak1 Freq")->load();
-    settings.peakGainInDecibels1 = apvts.getRawParameterValue("Peak1 Gain")->load();
-    settings.peakQuality1 = apvts.getRawParameterValue("Peak1 Quality")->load();
-    settings.peakFreq2 = apvts.getRawParameterValue("Peak2 Freq")->load();
-    settings.peakGainInDecibels2 = apvts.getRawParameterValue("Peak2 Gain")->load();
-    settings.peakQuality2 = apvts.getRawParameterValue("Peak2 Quality")->load();
-    settings.peakFreq3 = apvts.getRawParameterValue("Peak3 Freq")->load();
-    settings.peakGainInDecibels3 = apvts.getRawParameterValue("Peak3 Gain")->load();
-    settings.peakQuality3 = apvts.getRawParameterValue("Peak3 Quality")->load();
-    settings.highShelfFreq = apvts.getRawParameterValue("HighShelf Freq")->load();
-    settings.highShelfGainInDecibels = apvts.getRawParameterValue("HighShelf Gain")->load();
-    settings.highShelfQuality = apvts.getRawParameterValue("HighShelf Quality")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
-    settings.highCutQuality = apvts.getRawParameterValue("HighCut Quality")->load();
-    return settings;
-}
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate, int peakIndex)
-{
-    switch (peakIndex)
-    {
-        case 1:
-            return juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-                sampleRate, chainSettings.peakFreq1, chainSettings.peakQuality1, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels1));
-        case 2:
-            return juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-                sampleRate, chainSettings.peakFreq2, chainSettings.peakQuality2, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels2));
-        case 3:
-            return juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-                sampleRate, chainSettings.peakFreq3, chainSettings.peakQuality3, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels3));
-        default:
-            jassertfalse; // Invalid peak index
-            return nullptr;
-    }
-}
-
-Coefficients makeLowShelfFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate,
-                                                             chainSettings.lowShelfFreq,
-                                                             chainSettings.lowShelfQuality,
-                                                             juce::Decibels::decibelsToGain(chainSettings.lowShelfGainInDecibels));
-}
-
-Coefficients makeHighShelfFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate,
-                                                              chainSettings.highShelfFreq,
-                                                              chainSettings.highShelfQuality,
-                                                              juce::Decibels::decibelsToGain(chainSettings.highShelfGainInDecibels));
-}
-
-void EQoonAudioProcessor::updatePeakFilters(const ChainSettings& chainSettings)
-{
-    auto peakCoefficients1 = makePeakFilter(chainSettings, getSampleRate(), 1);
-    update<ChainPositions::Peak1>(leftChain, peakCoefficients1);
-    update<ChainPositions::Peak1>(rightChain, peakCoefficients1);
-
-    auto peakCoefficients2 = makePeakFilter(chainSettings, getSampleRate(), 2);
-    update<ChainPositions::Peak2>(leftChain, peakCoefficients2);
-    update<ChainPositions::Peak2>(rightChain, peakCoefficients2);
-
-    auto peakCoefficients3 = makePeakFilter(chainSettings, getSampleRate(), 3);
-    update<ChainPositions::Peak3>(leftChain, peakCoefficients3);
-    update<ChainPositions::Peak3>(rightChain, peakCoefficients3);
-}
-
-void EQoonAudioProcessor::updateLowShelfFilter(const ChainSettings& chainSettings)
-{
-    auto lowShelfCoefficients = makeLowShelfFilter(chainSettings, getSampleRate());
-    updateCoefficients(leftChain.get<ChainPositions::LowShelf>().coefficients, lowShelfCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::LowShelf>().coefficients, lowShelfCoefficients);
-}
-
-void EQoonAudioProcessor::updateHighShelfFilter(const ChainSettings& chainSettings)
-{
-    auto highShelfCoefficients = makeHighShelfFilter(chainSettings, getSampleRate());
-    updateCoefficients(leftChain.get<ChainPositions::HighShelf>().coefficients, highShelfCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::HighShelf>().coefficients, highShelfCoefficients);
-}
-
-void EQoonAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
-{
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    updateCutFilter(leftChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-}
-
-
-void EQoonAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
-{
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
-}
-
-void EQoonAudioProcessor::updateFilters()
-{
-    auto chainSettings = getChainSettings(apvts);
-    updateLowCutFilters(chainSettings);
-    updatePeakFilters(chainSettings);
-    updateLowShelfFilter(chainSettings);
-    updateHighShelfFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
-}
-
-
-juce::AudioProcessorValueTreeState::ParameterLayout EQoonAudioProcessor::createParameterLayout()
-{
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-    
-    juce::StringArray slopeSteep;
-    for (int i = 0; i < 4; ++i)
-    {
-        juce::String str;
-        str << (12 + i * 12);
-        str << " dB/oct";
-        slopeSteep.add(str);
-    }
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq",
-                                                           "LowCut Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
-                                                           20.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Quality",
-                                                           "LowCut Quality",
-                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-                                                           1.f));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", slopeSteep, 0));
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowShelf Freq",
-                                                           "LowShelf Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
-                                                           200.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowShelf Gain",
-                                                           "LowShelf Gain",
-                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-                                                           0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowShelf Quality",
-                                                           "LowShelf Quality",
-                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-                                                           1.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Freq",
-                                                           "Peak1 Freq",
-                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.f, 0.3f),
-                                                           750.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Gain",
-                                                           "Peak1 Gain",
-                                                           -24.0f, 24.0f, 0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Quality",
-                                                           "Peak1 Quality",
-                                                           0.1f, 10.0f, 1.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Freq",
-                                                           "Peak2 Freq",
-                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.f, 0.3f),
-                                                           1500.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Gain",
-                                                           "Peak2 Gain",
-                                                           -24.0f, 24.0f, 0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Quality",
-                                                           "Peak2 Quality",
-                                                           0.1f, 10.0f, 1.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Freq",
-                                                           "Peak3 Freq",
-                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.f, 0.3f),
-                                                           3000.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Gain",
-                                                           "Peak3 Gain",
-                                                           -24.0f, 24.0f, 0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Quality",
-                                                           "Peak3 Quality",
-                                                           0.1f, 10.0f, 1.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighShelf Freq",
-                                                           "HighShelf Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
-                                                           10000.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighShelf Gain",
-                                                           "HighShelf Gain",
-                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-                                                           0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighShelf Quality",
-                                                           "HighShelf Quality",
-                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-                                                           1.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq",
-                                                           "HighCut Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
-                                                           20000.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Quality",
-                                                           "HighCut Quality",
-                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-                                                           1.f));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", slopeSteep, 0));
-
-    return layout;
-}
-
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new EQoonAudioProcessor();
-}
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+static juce::uint32 getBandFlagForParameter(const juce::String& parameterID)
+{
+    if (parameterID == "Filter Topology" || parameterID == "Filter Precision" || parameterID == "Phase Mode"
+        || parameterID == "Band Design" || parameterID.startsWith("Oversampling") || parameterID == "Parallel Channels"
+        || parameterID == "Dynamics Detector")
+        return allBandFlags;
+    if (parameterID.startsWith("LowCut"))
+        return getBandFlag(ChainPositions::LowCut);
+    if (parameterID.startsWith("LowShelf"))
+        return getBandFlag(ChainPositions::LowShelf);
+    if (parameterID.startsWith("Peak1"))
+        return getBandFlag(ChainPositions::Peak1);
+    if (parameterID.startsWith("Peak2"))
+        return getBandFlag(ChainPositions::Peak2);
+    if (parameterID.startsWith("Peak3"))
+        return getBandFlag(ChainPositions::Peak3);
+    if (parameterID.startsWith("HighShelf"))
+        return getBandFlag(ChainPositions::HighShelf);
+    if (parameterID.startsWith("HighCut"))
+        return getBandFlag(ChainPositions::HighCut);
+
+    jassertfalse; // Parameter without a band
+    return allBandFlags;
+}
+
+
+
+EQoonAudioProcessor::EQoonAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       )
+#endif
+{
+    for (auto* param : getParameters())
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.addParameterListener(paramWithID->paramID, this);
+
+    designThread->addTimeSliceClient(this);
+}
+
+EQoonAudioProcessor::~EQoonAudioProcessor()
+{
+    designThread->removeTimeSliceClient(this);
+    cancelPendingUpdate();
+
+    for (auto* param : getParameters())
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.removeParameterListener(paramWithID->paramID, this);
+}
+
+void EQoonAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    dirtyBands.fetch_or(getBandFlagForParameter(parameterID));
+}
+
+void EQoonAudioProcessor::markAllBandsDirty()
+{
+    dirtyBands.store(allBandFlags);
+}
+
+int EQoonAudioProcessor::useTimeSlice()
+{
+    publishSnapshot();
+    updateLinearPhaseKernel();
+    updateChannelWorkers();
+    return designIntervalMs;
+}
+
+// Starting and stopping the workers' threads takes a while, so only the design and
+// message threads do it, never publishSnapshot(), which offline blocks call on the audio
+// thread.
+void EQoonAudioProcessor::updateChannelWorkers()
+{
+    const juce::ScopedLock lock(channelWorkersLock);
+    auto numWorkers = 0;
+
+    {
+        const juce::SpinLock::ScopedLockType designGuard(designLock);
+        if (channelWorkersPrepared && designedSnapshot.settings.parallelChannels)
+            numWorkers = numChannelWorkers;
+    }
+
+    if (numWorkers == (channelWorkers != nullptr ? channelWorkers->getNumWorkers() : 0))
+        return;
+
+    // The block that holds the old pool finishes with it first.
+    audioChannelWorkers.store(nullptr);
+    while (channelWorkersInUse.load())
+        juce::Thread::yield();
+
+    channelWorkers.reset();
+
+    if (numWorkers > 0)
+    {
+        channelWorkers = std::make_unique<ChannelWorkerPool>(numWorkers);
+        audioChannelWorkers.store(channelWorkers.get());
+    }
+}
+
+// Samples until the impulse response of the active sections has fallen by 100 dB, from
+// the radius of each section's slowest pole. The sum over the sections bounds the tail
+// of the whole cascade.
+static double getDecayLengthInSamples(const FilterSnapshot& snapshot)
+{
+    constexpr double decayGain = 1.0e-5;
+    double length = 0.0;
+
+    for (size_t section = 0; section < snapshot.sections.size(); ++section)
+    {
+        const auto& c = snapshot.sections[section];
+        if (snapshot.bypassed[section] || (c[0] == c[3] && c[1] == c[4] && c[2] == c[5]))
+            continue;
+
+        auto a1 = c[4] / c[3];
+        auto a2 = c[5] / c[3];
+        auto discriminant = a1 * a1 - 4.0 * a2;
+        auto radius = discriminant < 0.0 ? std::sqrt(a2) : 0.5 * (std::abs(a1) + std::sqrt(discriminant));
+
+        if (radius > 1.0e-6)
+            length += std::log(decayGain) / std::log(juce::jmin(radius, 1.0 - 1.0e-9));
+    }
+
+    return length;
+}
+
+void EQoonAudioProcessor::publishSnapshot()
+{
+    const juce::SpinLock::ScopedLockType lock(designLock);
+
+    // A recall publishes once it has set every parameter; the dirty bits wait for it.
+    auto hostSampleRate = getSampleRate();
+    if (hostSampleRate <= 0.0 || recallInProgress.load())
+        return;
+
+    // Oversampling parameters mark every band dirty, so only the host rate is checked.
+    auto dirty = dirtyBands.exchange(0);
+    if (hostSampleRate != designedSnapshot.hostSampleRate)
+        dirty = allBandFlags;
+    if (dirty == 0)
+        return;
+
+    // In linear phase mode the stages don't run, but the kernel is still sampled from
+    // sections designed at the oversampled rate, so it isn't cramped either.
+    designedSnapshot.settings = chainParameters.load();
+    designedSnapshot.hostSampleRate = hostSampleRate;
+    designedSnapshot.sampleRate = hostSampleRate * (1 << designedSnapshot.settings.oversamplingOrder);
+    designSnapshot(designedSnapshot, dirty);
+    ++designedSnapshot.version;
+
+    // The decay follows the lowest cut and the sharpest resonance through the poles of
+    // the active sections; oversampling delays it by the stages' latency.
+    tailLengthSeconds.store(designedSnapshot.settings.phaseMode == PhaseMode::linear
+                              ? linearPhase.getKernelSize() / hostSampleRate
+                              : getDecayLengthInSamples(designedSnapshot) / designedSnapshot.sampleRate
+                                  + getLatencyForSettings(designedSnapshot.settings) / hostSampleRate);
+
+    snapshots.getWriteBuffer() = designedSnapshot;
+    snapshots.publish();
+
+    const juce::SpinLock::ScopedLockType guiLock(latestSnapshotLock);
+    latestSnapshot = designedSnapshot;
+    latestSnapshotVersion.store(designedSnapshot.version);
+}
+
+void EQoonAudioProcessor::updateLinearPhaseKernel()
+{
+    const juce::SpinLock::ScopedLockType lock(designLock);
+
+    // Hosts expect latency changes from the message thread.
+    auto latency = getLatencyForSettings(designedSnapshot.settings);
+    if (latency != reportedLatencySamples)
+    {
+        reportedLatencySamples = latency;
+        triggerAsyncUpdate();
+    }
+
+    // Offline, the audio thread loads kernels itself.
+    if (designedSnapshot.settings.phaseMode != PhaseMode::linear || designedSnapshot.version == kernelVersion
+        || designedSnapshot.sampleRate <= 0.0 || isNonRealtime())
+        return;
+
+    if (juce::Time::getMillisecondCounterHiRes() - lastKernelDesignMs < kernelDesignIntervalMs)
+        return;
+
+    designLinearPhaseKernel();
+}
+
+// The 2x2 matrix, { ll, lr, rl, rr }, that applies gain to the channels a routing
+// selects. Mid and side are M = (L + R) / 2 and S = (L - R) / 2, as in the banks.
+static std::array<double, 4> getRoutingMatrix(ChannelRouting routing, double gain)
+{
+    switch (routing)
+    {
+        case ChannelRouting::left:  return { gain, 0.0, 0.0, 1.0 };
+        case ChannelRouting::right: return { 1.0, 0.0, 0.0, gain };
+        case ChannelRouting::mid:   return { (gain + 1.0) * 0.5, (gain - 1.0) * 0.5, (gain - 1.0) * 0.5, (gain + 1.0) * 0.5 };
+        case ChannelRouting::side:  return { (1.0 + gain) * 0.5, (1.0 - gain) * 0.5, (1.0 - gain) * 0.5, (1.0 + gain) * 0.5 };
+        case ChannelRouting::stereo:
+        default:                    return { gain, 0.0, 0.0, gain };
+    }
+}
+
+// Offline renders can run far ahead of the design thread, so they design inline between
+// blocks, to keep automation in step with the audio. Every new version gets its kernel at
+// once, loaded in the same place in the audio on every render.
+void EQoonAudioProcessor::designInline()
+{
+    publishSnapshot();
+
+    const juce::SpinLock::ScopedLockType lock(designLock);
+    if (designedSnapshot.settings.phaseMode == PhaseMode::linear && designedSnapshot.version != kernelVersion
+        && designedSnapshot.sampleRate > 0.0 && ! linearPhase.isFading())
+        designLinearPhaseKernel(LinearPhaseFir::KernelLoad::immediate);
+}
+
+void EQoonAudioProcessor::designLinearPhaseKernel(LinearPhaseFir::KernelLoad load)
+{
+    const auto& snapshot = designedSnapshot;
+    auto routed = false;
+
+    for (size_t section = 0; section < snapshot.sections.size(); ++section)
+        routed = routed || (! snapshot.bypassed[section] && snapshot.routing[section] != ChannelRouting::stereo);
+
+    if (routed && linearPhase.getNumChannels() == 2)
+    {
+        linearPhase.designMatrix([&snapshot](double frequency)
+        {
+            std::array<double, 4> matrix { 1.0, 0.0, 0.0, 1.0 };
+
+            // Each section's matrix multiplies from the left, in cascade order.
+            for (size_t section = 0; section < snapshot.sections.size(); ++section)
+            {
+                if (snapshot.bypassed[section])
+                    continue;
+
+                auto gain = getMagnitudeForFrequency(snapshot.sections[section], frequency, snapshot.sampleRate);
+                auto m = getRoutingMatrix(snapshot.routing[section], gain);
+                matrix = { m[0] * matrix[0] + m[1] * matrix[2], m[0] * matrix[1] + m[1] * matrix[3],
+                           m[2] * matrix[0] + m[3] * matrix[2], m[2] * matrix[1] + m[3] * matrix[3] };
+            }
+
+            return matrix;
+        }, load);
+    }
+    else
+    {
+        linearPhase.design([&snapshot](double frequency)
+        {
+            double magnitude = 1.0;
+
+            for (size_t section = 0; section < snapshot.sections.size(); ++section)
+                if (! snapshot.bypassed[section])
+                    magnitude *= getMagnitudeForFrequency(snapshot.sections[section], frequency, snapshot.sampleRate);
+
+            return magnitude;
+        }, load);
+    }
+
+    kernelVersion = snapshot.version;
+    lastKernelDesignMs = juce::Time::getMillisecondCounterHiRes();
+}
+
+void EQoonAudioProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
+
+void EQoonAudioProcessor::updateLatency()
+{
+    auto settings = chainParameters.load();
+    int latency;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(designLock);
+        latency = getLatencyForSettings(settings);
+    }
+
+    setLatencySamples(latency);
+}
+
+// Call with designLock held: prepareToPlay() rebuilds what this reads.
+int EQoonAudioProcessor::getLatencyForSettings(const ChainSettings& settings) const
+{
+    if (settings.phaseMode == PhaseMode::linear)
+        return linearPhase.getLatencySamples();
+
+    return isUsingDoublePrecision() ? doubleOversamplers.getLatencySamples(settings)
+                                    : floatOversamplers.getLatencySamples(settings);
+}
+
+void EQoonAudioProcessor::applyPendingSnapshot()
+{
+    if (! snapshots.update())
+        return;
+
+    const auto& target = snapshots.getReadBuffer();
+    const auto& current = glide.getSnapshot();
+
+    // A new sample rate (or the very first design) has nothing sensible to glide from,
+    // and a bank that was idle starts from silence rather than from stale state.
+    auto banksChanged = SnapshotGlide::switchesBanks(current.settings, target.settings)
+                     || usesDoubleBanks(target) != usesDoubleBanks(current);
+    if (target.sampleRate != current.sampleRate || banksChanged)
+    {
+        if (banksChanged)
+        {
+            floatBanks.reset();
+            doubleBanks.reset();
+            floatOversamplers.reset();
+            doubleOversamplers.reset();
+        }
+
+        glide.jumpTo(target);
+        applyToActiveBanks(target);
+        floatBanks.jumpToTargets();
+        doubleBanks.jumpToTargets();
+        appliedRecallCount = target.recallCount;
+        recallFadeRemaining = 0;
+        return;
+    }
+
+    if (target.recallCount != appliedRecallCount)
+    {
+        startRecallFade(target);
+        return;
+    }
+
+    glide.glideTo(target);
+}
+
+// Hosts that render in double always get the double banks, with no conversion.
+bool EQoonAudioProcessor::usesDoubleBanks(const FilterSnapshot& snapshot) const
+{
+    return isUsingDoublePrecision() || snapshot.settings.precision == FilterPrecision::float64;
+}
+
+void EQoonAudioProcessor::applyToActiveBanks(const FilterSnapshot& snapshot)
+{
+    if (usesDoubleBanks(snapshot))
+        doubleBanks.apply(snapshot);
+    else
+        floatBanks.apply(snapshot);
+}
+
+// Settles on the latest design at once, without any dynamics, where a glide would only
+// be spent on silence.
+void EQoonAudioProcessor::jumpToPendingSnapshot()
+{
+    glide.jumpTo(snapshots.getReadBuffer());
+    applyToActiveBanks(glide.getSnapshot());
+    floatBanks.jumpToTargets();
+    doubleBanks.jumpToTargets();
+    appliedRecallCount = glide.getSnapshot().recallCount;
+    recallFadeRemaining = 0;
+}
+
+// Swaps a recalled preset in whole. The banks that ran until now become the fading set
+// and carry on with the old sections, on a copy of the input, while the other set starts
+// from silence with the new ones; processFilters() crossfades between the two. A recall
+// during a fade keeps whichever set the output is closer to as the one fading out.
+void EQoonAudioProcessor::startRecallFade(const FilterSnapshot& target)
+{
+    glide.jumpTo(target);
+    appliedRecallCount = target.recallCount;
+
+    // Idle banks have nothing to fade from, and the linear phase kernel crossfades on
+    // its own.
+    auto fades = ! chainIdle && target.settings.phaseMode == PhaseMode::minimum;
+
+    if (fades)
+    {
+        if (recallFadeRemaining == 0 || 2 * recallFadeRemaining <= recallFadeLength)
+        {
+            std::swap(floatBanks, floatFadingBanks);
+            std::swap(doubleBanks, doubleFadingBanks);
+        }
+
+        floatBanks.reset();
+        doubleBanks.reset();
+    }
+
+    applyToActiveBanks(target);
+    floatBanks.jumpToTargets();
+    doubleBanks.jumpToTargets();
+
+    recallFadeLength = juce::jmax(1, juce::roundToInt(recallFadeSeconds * target.sampleRate));
+    recallFadeRemaining = fades ? recallFadeLength : 0;
+}
+
+template <typename SampleType>
+void EQoonAudioProcessor::runDetectors(juce::AudioBuffer<SampleType>& buffer, const juce::dsp::AudioBlock<SampleType>& mainBlock)
+{
+    const auto& settings = glide.getSnapshot().settings;
+    dynamicsActive = false;
+
+    for (int position = ChainPositions::LowShelf; position <= ChainPositions::HighShelf; ++position)
+    {
+        const auto& fields = bandFields[(size_t) position];
+        auto detector = position == ChainPositions::LowShelf  ? BandDynamics::Detector::lowPass
+                      : position == ChainPositions::HighShelf ? BandDynamics::Detector::highPass
+                                                              : BandDynamics::Detector::bandPass;
+
+        BandDynamics::Band band { settings.phaseMode == PhaseMode::minimum && settings.*fields.ratio > 1.f, detector,
+                                  settings.*fields.frequency, settings.*fields.quality,
+                                  settings.*fields.attack, settings.*fields.release, settings.*fields.routing };
+        dynamics.setBand((size_t) (position - ChainPositions::LowShelf), band);
+        dynamicsActive = dynamicsActive || band.enabled;
+    }
+
+    if (! dynamicsActive)
+        return;
+
+    auto* sidechain = getBusCount(true) > 1 ? getBus(true, 1) : nullptr;
+
+    if (settings.detectorSource == DetectorSource::sidechain && sidechain != nullptr && sidechain->isEnabled()
+        && sidechain->getNumberOfChannels() > 0)
+    {
+        auto sidechainBuffer = getBusBuffer(buffer, true, 1);
+        dynamics.process(juce::dsp::AudioBlock<const SampleType>(sidechainBuffer));
+    }
+    else
+    {
+        dynamics.process(juce::dsp::AudioBlock<const SampleType>(mainBlock));
+    }
+}
+
+// Called on the control grid. The gain change of each dynamic band is kept in the
+// snapshot, so glides that redesign the band in between keep it too.
+void EQoonAudioProcessor::advanceDynamics(int hostSample)
+{
+    // Smaller steps aren't worth a redesign.
+    constexpr float minStepDecibels = 0.01f;
+    const auto& settings = glide.getSnapshot().settings;
+    auto gains = glide.getSnapshot().dynamicGainInDecibels;
+    juce::uint32 changedBands = 0;
+
+    for (int position = ChainPositions::LowShelf; position <= ChainPositions::HighShelf; ++position)
+    {
+        auto index = (size_t) (position - ChainPositions::LowShelf);
+        const auto& fields = bandFields[(size_t) position];
+        auto change = dynamicsActive && dynamics.isEnabled(index)
+                        ? BandDynamics::getGainChangeDecibels(dynamics.getLevelDecibels(index, hostSample),
+                                                              settings.*fields.threshold, settings.*fields.ratio)
+                        : 0.f;
+
+        auto& current = gains[(size_t) position];
+        if (std::abs(change - current) > minStepDecibels || (change == 0.f && current != 0.f))
+        {
+            current = change;
+            changedBands |= getBandFlag(static_cast<ChainPositions>(position));
+        }
+    }
+
+    if (changedBands != 0)
+    {
+        glide.setDynamicGains(gains, changedBands);
+        applyToActiveBanks(glide.getSnapshot());
+    }
+}
+
+// Returns true when every channel is idle. The chain clears the filters, the oversampling
+// stages and the detectors as it goes idle, so it starts again from silence.
+template <typename SampleType>
+bool EQoonAudioProcessor::updateIdleChannels(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    constexpr int maxSilentSamples = std::numeric_limits<int>::max() / 2;
+    auto numSamples = static_cast<int>(block.getNumSamples());
+    auto numChannels = juce::jmin(block.getNumChannels(), silentSamples.size());
+    auto tailSamples = static_cast<int>(std::ceil(tailLengthSeconds.load(std::memory_order_relaxed) * getSampleRate()));
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        // Audio rarely ends on a silent sample, so this stops at once unless the block is
+        // silent towards its end.
+        auto* samples = block.getChannelPointer(channel);
+        auto last = numSamples - 1;
+        while (last >= 0 && std::abs(samples[last]) <= static_cast<SampleType>(silenceThreshold))
+            --last;
+
+        auto& count = silentSamples[channel];
+        count = last < 0 ? juce::jmin(maxSilentSamples, count + numSamples) : numSamples - 1 - last;
+    }
+
+    // Silent for the whole block and for the tail before it.
+    auto isChannelIdle = [&](size_t channel) { return silentSamples[channel] - numSamples >= tailSamples; };
+
+    auto allIdle = numChannels > 0;
+    for (size_t channel = 0; allIdle && channel < numChannels; ++channel)
+        allIdle = isChannelIdle(channel);
+
+    if (! allIdle)
+    {
+        if (usesDoubleBanks(glide.getSnapshot()))
+            doubleBanks.updateIdleGroups(numChannels, isChannelIdle);
+        else
+            floatBanks.updateIdleGroups(numChannels, isChannelIdle);
+
+        if (recallFadeRemaining > 0)
+        {
+            if (usesDoubleBanks(glide.getSnapshot()))
+                doubleFadingBanks.updateIdleGroups(numChannels, isChannelIdle);
+            else
+                floatFadingBanks.updateIdleGroups(numChannels, isChannelIdle);
+        }
+    }
+    else
+    {
+        if (! chainIdle)
+        {
+            floatBanks.reset();
+            doubleBanks.reset();
+            floatOversamplers.reset();
+            doubleOversamplers.reset();
+            dynamics.reset();
+        }
+
+        if (! chainIdle || glide.isGliding())
+            jumpToPendingSnapshot();
+
+        glide.skip(numSamples << glide.getSnapshot().settings.oversamplingOrder);
+    }
+
+    chainIdle = allIdle;
+    return allIdle;
+}
+
+template <typename SampleType>
+void EQoonAudioProcessor::processFilters(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    auto numSamples = static_cast<int>(block.getNumSamples());
+
+    // The glide splits the block on its grid while it moves, and so do the dynamics and
+    // the SVF banks' ramps; the grid keeps its phase either way so the ticks don't move
+    // with the host's buffer size.
+    glide.process(numSamples, numSamples,
+                  [this](int start)
+                  {
+                      ProcessLoadMeter::ScopedStage coefficientTimer(loadMeter, ProcessLoadMeter::coefficients);
+
+                      if (glide.advance())
+                          applyToActiveBanks(glide.getSnapshot());
+
+                      advanceDynamics(start >> glide.getSnapshot().settings.oversamplingOrder);
+                  },
+                  [this]
+                  {
+                      return dynamicsActive || (usesDoubleBanks(glide.getSnapshot()) ? doubleBanks.isRamping()
+                                                                                     : floatBanks.isRamping());
+                  },
+                  [this, &block](int start, int length)
+                  {
+                      processBanks(block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(length)));
+                  });
+}
+
+template <typename SampleType>
+void EQoonAudioProcessor::processBanks(juce::dsp::AudioBlock<SampleType> subBlock)
+{
+    auto length = static_cast<int>(subBlock.getNumSamples());
+    auto useDoubleBanks = usesDoubleBanks(glide.getSnapshot());
+    juce::dsp::ProcessContextReplacing<SampleType> context(subBlock);
+    auto topology = glide.getSnapshot().settings.topology;
+    auto sharesGroups = glide.getSnapshot().settings.parallelChannels && (size_t) length >= minParallelBlockSize;
+    ChannelWorkerPool* workers = nullptr;
+
+    // Marked before the pool is read, so updateChannelWorkers() either sees the mark or
+    // has already taken the pool away.
+    if (sharesGroups)
+    {
+        channelWorkersInUse.store(true);
+        workers = audioChannelWorkers.load();
+    }
+
+    // During a recall the fading set filters a copy of the input before the current
+    // set filters the block in place.
+    auto fadeSamples = juce::jmin(length, recallFadeRemaining);
+    juce::dsp::AudioBlock<SampleType> fadingBlock;
+
+    if (fadeSamples > 0)
+    {
+        fadingBlock = juce::dsp::AudioBlock<SampleType>(getRecallInput(SampleType()))
+                        .getSubsetChannelBlock(0, subBlock.getNumChannels())
+                        .getSubBlock(0, static_cast<size_t>(fadeSamples));
+        fadingBlock.copyFrom(subBlock);
+        juce::dsp::ProcessContextReplacing<SampleType> fadingContext(fadingBlock);
+
+        if (useDoubleBanks)
+            doubleFadingBanks.process(fadingContext, topology, workers);
+        else
+            floatFadingBanks.process(fadingContext, topology, workers);
+    }
+
+    if (useDoubleBanks)
+        doubleBanks.process(context, topology, workers);
+    else
+        floatBanks.process(context, topology, workers);
+
+    if (sharesGroups)
+        channelWorkersInUse.store(false);
+
+    if (fadeSamples > 0)
+    {
+        // The new set fades in linearly from where the fade stands.
+        auto step = SampleType(1) / static_cast<SampleType>(recallFadeLength);
+        auto startGain = static_cast<SampleType>(recallFadeLength - recallFadeRemaining) * step;
+
+        for (size_t channel = 0; channel < subBlock.getNumChannels(); ++channel)
+        {
+            auto* samples = subBlock.getChannelPointer(channel);
+            const auto* fading = fadingBlock.getChannelPointer(channel);
+            auto gain = startGain;
+
+            for (int i = 0; i < fadeSamples; ++i)
+            {
+                gain += step;
+                samples[i] = fading[i] + gain * (samples[i] - fading[i]);
+            }
+        }
+
+        recallFadeRemaining -= fadeSamples;
+    }
+}
+
+FilterSnapshot EQoonAudioProcessor::getLatestSnapshot() const
+{
+    const juce::SpinLock::ScopedLockType lock(latestSnapshotLock);
+    return latestSnapshot;
+}
+
+const juce::String EQoonAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool EQoonAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool EQoonAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool EQoonAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double EQoonAudioProcessor::getTailLengthSeconds() const
+{
+    return tailLengthSeconds.load();
+}
+
+int EQoonAudioProcessor::getNumPrograms()
+{
+    return 1;
+}
+
+int EQoonAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void EQoonAudioProcessor::setCurrentProgram (int index)
+{
+}
+
+const juce::String EQoonAudioProcessor::getProgramName (int index)
+{
+    return {};
+}
+
+void EQoonAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+}
+
+void EQoonAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = samplesPerBlock;
+    spec.numChannels = getTotalNumOutputChannels();
+
+    glide.clear();
+    dynamics.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    silentSamples.assign(spec.numChannels, 0);
+    chainIdle = false;
+    recallFadeRemaining = 0;
+    loadMeter.prepare(sampleRate);
+
+    // The banks run on the oversampled blocks, and must have all their channel groups
+    // before the first snapshot is applied.
+    auto bankSpec = spec;
+    bankSpec.maximumBlockSize = spec.maximumBlockSize << Oversamplers<float>::maxOrder;
+    floatBanks.prepare(bankSpec);
+    doubleBanks.prepare(bankSpec);
+    floatFadingBanks.prepare(bankSpec);
+    doubleFadingBanks.prepare(bankSpec);
+
+    // The copy of the input a recall fades out from, at the host's precision.
+    if (isUsingDoublePrecision())
+    {
+        doubleRecallInput.setSize((int) bankSpec.numChannels, (int) bankSpec.maximumBlockSize);
+        floatRecallInput.setSize(0, 0);
+    }
+    else
+    {
+        floatRecallInput.setSize((int) bankSpec.numChannels, (int) bankSpec.maximumBlockSize);
+        doubleRecallInput.setSize(0, 0);
+    }
+
+    {
+        // Enough workers for the groups of the double banks, which have the fewest lanes.
+        // The pool itself waits for the first design, below.
+        const juce::ScopedLock lock(channelWorkersLock);
+        numChannelWorkers = juce::jmax(0, juce::jmin(maxChannelWorkers, juce::SystemStats::getNumCpus() - 1,
+                                                     FilterBanks<double>::getNumGroups(spec.numChannels) - 1));
+    }
+
+    {
+        // The kernel follows the sample rate, so prepare and design it before anything
+        // reads its size. The design thread reads the stages' latencies too.
+        const juce::SpinLock::ScopedLockType lock(designLock);
+        linearPhase.prepare(spec);
+
+        if (isUsingDoublePrecision())
+        {
+            doubleOversamplers.prepare(spec.numChannels, spec.maximumBlockSize);
+            floatOversamplers.release();
+        }
+        else
+        {
+            floatOversamplers.prepare(spec.numChannels, spec.maximumBlockSize);
+            doubleOversamplers.release();
+        }
+    }
+
+    // Drops events queued for a block that never came.
+    parameterEvents.clear();
+
+    markAllBandsDirty();
+    publishSnapshot();
+    applyPendingSnapshot();
+
+    {
+        const juce::SpinLock::ScopedLockType lock(designLock);
+        channelWorkersPrepared = true;
+    }
+
+    updateChannelWorkers();
+
+    {
+        // The first kernel prepares the convolutions, so it runs from the first block with
+        // the latency reported here.
+        const juce::SpinLock::ScopedLockType lock(designLock);
+        if (designedSnapshot.sampleRate > 0.0)
+            designLinearPhaseKernel();
+        reportedLatencySamples = getLatencyForSettings(designedSnapshot.settings);
+    }
+
+    updateLatency();
+}
+
+void EQoonAudioProcessor::releaseResources()
+{
+    // Stops the channel workers until the next prepareToPlay().
+    {
+        const juce::SpinLock::ScopedLockType lock(designLock);
+        channelWorkersPrepared = false;
+    }
+
+    updateChannelWorkers();
+}
+
+// Forgets the audio so far, as hosts ask when the playhead jumps, and runs the parameters
+// as they are now instead of gliding to them. Not while a block runs. Offline, a new
+// linear phase kernel is loaded before it returns.
+void EQoonAudioProcessor::reset()
+{
+    // Nothing has run since prepareToPlay(), which starts from silence anyway.
+    if (glide.getSnapshot().sampleRate <= 0.0)
+        return;
+
+    floatBanks.reset();
+    doubleBanks.reset();
+    floatFadingBanks.reset();
+    doubleFadingBanks.reset();
+    floatOversamplers.reset();
+    doubleOversamplers.reset();
+    dynamics.reset();
+    std::fill(silentSamples.begin(), silentSamples.end(), 0);
+    chainIdle = false;
+    parameterEvents.clear();
+
+    publishSnapshot();
+    snapshots.update();
+    jumpToPendingSnapshot();
+    glide.restartGrid();
+
+    const juce::SpinLock::ScopedLockType lock(designLock);
+    if (designedSnapshot.settings.phaseMode == PhaseMode::linear && designedSnapshot.version != kernelVersion
+        && designedSnapshot.sampleRate > 0.0)
+        designLinearPhaseKernel(isNonRealtime() ? LinearPhaseFir::KernelLoad::immediate
+                                                : LinearPhaseFir::KernelLoad::background);
+
+    // Drops the fade into an immediate kernel along with the old audio.
+    linearPhase.reset();
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool EQoonAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // Any layout, up to third order ambisonics and beyond: the banks grow a channel
+    // group per SIMD register of channels.
+    if (layouts.getMainOutputChannelSet().isDisabled())
+        return false;
+
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    // The sidechain only feeds the dynamics detectors, so it may have any layout.
+    return true;
+  #endif
+}
+#endif
+
+void EQoonAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSegments(buffer);
+}
+
+void EQoonAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSegments(buffer);
+}
+
+// Parameters are set between the parts, outside the real-time region, as the plug-in
+// wrappers set them before a block. Each part ends on the first control tick at or
+// after the next event: the values only start gliding on a tick anyway, so events
+// between two ticks share one split and the control grid keeps its phase.
+template <typename SampleType>
+void EQoonAudioProcessor::processSegments(juce::AudioBuffer<SampleType>& buffer)
+{
+    constexpr auto lastOffset = std::numeric_limits<int>::max();
+    auto numSamples = buffer.getNumSamples();
+    ProcessLoadMeter::ScopedBlock loadTimer(loadMeter, numSamples);
+
+    if (! parameterEvents.hasPending() || ! isNonRealtime())
+    {
+        parameterEvents.applyUpTo(lastOffset);
+        processSamples(buffer);
+        return;
+    }
+
+    for (int start = 0; start < numSamples;)
+    {
+        parameterEvents.applyUpTo(start);
+        auto end = numSamples;
+
+        if (parameterEvents.hasPending())
+        {
+            auto order = glide.getSnapshot().settings.oversamplingOrder;
+            auto tickInterval = SnapshotGlide::controlInterval >> order;
+            auto firstTick = start + (glide.getSamplesUntilTick() >> order);
+            auto ticksAway = (juce::jmax(0, parameterEvents.getNextOffset() - firstTick) + tickInterval - 1) / tickInterval;
+            end = juce::jmin(numSamples, firstTick + ticksAway * tickInterval);
+        }
+
+        juce::AudioBuffer<SampleType> segment(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                              start, end - start);
+        processSamples(segment);
+        start = end;
+    }
+
+    // Offsets past the end of the block.
+    parameterEvents.applyUpTo(lastOffset);
+}
+
+template <typename SampleType>
+void EQoonAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
+{
+    // Kernel loads allocate, so this comes before the real-time region.
+    if (isNonRealtime())
+    {
+        ProcessLoadMeter::ScopedStage coefficientTimer(loadMeter, ProcessLoadMeter::coefficients);
+        designInline();
+    }
+
+    RealtimeSafety::ScopedRegion realtimeRegion;
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    {
+        ProcessLoadMeter::ScopedStage coefficientTimer(loadMeter, ProcessLoadMeter::coefficients);
+        applyPendingSnapshot();
+    }
+
+    // The sidechain, if the host enabled it, follows the main channels in the buffer.
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    juce::dsp::AudioBlock<SampleType> block(mainBuffer);
+
+    if (preEqTapEnabled.load(std::memory_order_relaxed))
+    {
+        ProcessLoadMeter::ScopedStage analysisTimer(loadMeter, ProcessLoadMeter::analysis);
+        preEqFifo.push(juce::dsp::AudioBlock<const SampleType>(block));
+    }
+
+    // Silent input that has outlasted the tail leaves nothing to filter, so it passes
+    // straight through.
+    if (! updateIdleChannels(block))
+    {
+        {
+            ProcessLoadMeter::ScopedStage analysisTimer(loadMeter, ProcessLoadMeter::analysis);
+            runDetectors(buffer, block);
+        }
+
+        if (glide.getSnapshot().settings.phaseMode == PhaseMode::linear)
+        {
+            linearPhase.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+        }
+        else if (auto* oversampling = getOversamplers(SampleType()).get(glide.getSnapshot().settings))
+        {
+            processFilters(oversampling->processSamplesUp(block));
+            oversampling->processSamplesDown(block);
+        }
+        else
+        {
+            processFilters(block);
+        }
+    }
+
+    if (postEqTapEnabled.load(std::memory_order_relaxed))
+    {
+        ProcessLoadMeter::ScopedStage analysisTimer(loadMeter, ProcessLoadMeter::analysis);
+        postEqFifo.push(juce::dsp::AudioBlock<const SampleType>(block));
+    }
+}
+
+void EQoonAudioProcessor::setAnalyzerTaps(bool preEq, bool postEq)
+{
+    preEqTapEnabled.store(preEq);
+    postEqTapEnabled.store(postEq);
+}
+
+bool EQoonAudioProcessor::addParameterEvent(int parameterIndex, int sampleOffset, float normalisedValue)
+{
+    auto* parameter = getParameters()[parameterIndex];
+    return parameter != nullptr && parameterEvents.add(*parameter, sampleOffset, normalisedValue);
+}
+
+bool EQoonAudioProcessor::hasEditor() const
+{
+    return true;
+}
+
+juce::AudioProcessorEditor* EQoonAudioProcessor::createEditor()
+{
+    return new EQoonAudioProcessorEditor (*this);
+}
+
+// The state: a tag and a version, each parameter's plain value under a hash of its ID,
+// then the properties of the state tree (the editor's settings), in about 8 bytes a
+// parameter where the ValueTree took around 60. Later versions only append, so older
+// builds read what they know. Parameters a state doesn't have take their defaults, and
+// values for parameters this build doesn't have are skipped.
+static const auto stateMagic = (int) juce::ByteOrder::littleEndianInt("EQon");
+static constexpr int stateVersion = 1;
+
+// FNV-1a over the ID's UTF-8, so the hashes are the same in every build.
+static juce::uint32 getParameterHash(const juce::String& parameterID)
+{
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint8) *c) * 16777619u;
+
+    return hash;
+}
+
+void EQoonAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    for (auto* param : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            parameters.add(ranged);
+
+    juce::MemoryOutputStream mos(destData, true);
+    mos.writeInt(stateMagic);
+    mos.writeInt(stateVersion);
+    mos.writeCompressedInt(parameters.size());
+
+    for (auto* parameter : parameters)
+    {
+        mos.writeInt((int) getParameterHash(parameter->paramID));
+        mos.writeFloat(parameter->convertFrom0to1(parameter->getValue()));
+    }
+
+    mos.writeCompressedInt(apvts.state.getNumProperties());
+
+    for (int i = 0; i < apvts.state.getNumProperties(); ++i)
+    {
+        auto name = apvts.state.getPropertyName(i);
+        mos.writeString(name.toString());
+        apvts.state.getProperty(name).writeToStream(mos);
+    }
+}
+
+void EQoonAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    juce::HashMap<juce::uint32, float> values;
+    juce::ValueTree properties;
+    juce::MemoryInputStream mis(data, (size_t) juce::jmax(0, sizeInBytes), false);
+
+    if (sizeInBytes >= 8 && mis.readInt() == stateMagic)
+    {
+        if (mis.readInt() < 1)
+            return;
+
+        for (auto count = mis.readCompressedInt(); --count >= 0 && ! mis.isExhausted();)
+        {
+            auto hash = (juce::uint32) mis.readInt();
+            values.set(hash, mis.readFloat());
+        }
+
+        properties = juce::ValueTree(apvts.state.getType());
+
+        for (auto count = mis.readCompressedInt(); --count >= 0 && ! mis.isExhausted();)
+        {
+            auto name = mis.readString();
+            properties.setProperty(name, juce::var::readFromStream(mis), nullptr);
+        }
+    }
+    else
+    {
+        // Earlier builds saved the parameter tree itself, as XML or as a ValueTree.
+        if (auto xml = getXmlFromBinary(data, sizeInBytes))
+            properties = juce::ValueTree::fromXml(*xml);
+        else
+            properties = juce::ValueTree::readFromData(data, (size_t) juce::jmax(0, sizeInBytes));
+
+        if (! properties.isValid())
+            return;
+
+        for (const auto& child : properties)
+            if (child.hasType("PARAM"))
+                values.set(getParameterHash(child["id"].toString()), (float) child["value"]);
+    }
+
+    recallState(values, properties);
+}
+
+// Sets every parameter with the design thread held off, then designs the whole preset at
+// once on this thread and publishes it as a recall. The audio thread crossfades to it in
+// one go, rather than gliding through the parameters as the design thread catches them.
+void EQoonAudioProcessor::recallState(const juce::HashMap<juce::uint32, float>& values,
+                                      const juce::ValueTree& properties)
+{
+    recallInProgress.store(true);
+
+    {
+        // Waits for a design that started before the flag was set.
+        const juce::SpinLock::ScopedLockType lock(designLock);
+    }
+
+    for (auto* param : getParameters())
+    {
+        if (auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(param))
+        {
+            auto hash = getParameterHash(parameter->paramID);
+            parameter->setValueNotifyingHost(values.contains(hash) ? parameter->convertTo0to1(values[hash])
+                                                                   : parameter->getDefaultValue());
+        }
+    }
+
+    apvts.state.copyPropertiesFrom(properties, nullptr);
+
+    {
+        const juce::SpinLock::ScopedLockType lock(designLock);
+        ++designedSnapshot.recallCount;
+        recallInProgress.store(false);
+    }
+
+    markAllBandsDirty();
+    publishSnapshot();
+
+    // The kernel too, rather than at the design thread's next interval. Offline, the
+    // next block loads it.
+    const juce::SpinLock::ScopedLockType lock(designLock);
+    if (designedSnapshot.settings.phaseMode == PhaseMode::linear && designedSnapshot.sampleRate > 0.0
+        && ! isNonRealtime())
+        designLinearPhaseKernel();
+}
+
+static const std::array<std::pair<const char*, float ChainSettings::*>, 39> floatParameters
+{{
+    { "LowCut Freq", &ChainSettings::lowCutFreq },
+    { "LowCut Quality", &ChainSettings::lowCutQuality },
+    { "LowShelf Freq", &ChainSettings::lowShelfFreq },
+    { "LowShelf Gain", &ChainSettings::lowShelfGainInDecibels },
+    { "LowShelf Quality", &ChainSettings::lowShelfQuality },
+    { "Peak1 Freq", &ChainSettings::peakFreq1 },
+    { "Peak1 Gain", &ChainSettings::peakGainInDecibels1 },
+    { "Peak1 Quality", &ChainSettings::peakQuality1 },
+    { "Peak2 Freq", &ChainSettings::peakFreq2 },
+    { "Peak2 Gain", &ChainSettings::peakGainInDecibels2 },
+    { "Peak2 Quality", &ChainSettings::peakQuality2 },
+    { "Peak3 Freq", &ChainSettings::peakFreq3 },
+    { "Peak3 Gain", &ChainSettings::peakGainInDecibels3 },
+    { "Peak3 Quality", &ChainSettings::peakQuality3 },
+    { "HighShelf Freq", &ChainSettings::highShelfFreq },
+    { "HighShelf Gain", &ChainSettings::highShelfGainInDecibels },
+    { "HighShelf Quality", &ChainSettings::highShelfQuality },
+    { "HighCut Freq", &ChainSettings::highCutFreq },
+    { "HighCut Quality", &ChainSettings::highCutQuality },
+    { "LowShelf Threshold", &ChainSettings::lowShelfThreshold },
+    { "LowShelf Ratio", &ChainSettings::lowShelfRatio },
+    { "LowShelf Attack", &ChainSettings::lowShelfAttack },
+    { "LowShelf Release", &ChainSettings::lowShelfRelease },
+    { "Peak1 Threshold", &ChainSettings::peakThreshold1 },
+    { "Peak1 Ratio", &ChainSettings::peakRatio1 },
+    { "Peak1 Attack", &ChainSettings::peakAttack1 },
+    { "Peak1 Release", &ChainSettings::peakRelease1 },
+    { "Peak2 Threshold", &ChainSettings::peakThreshold2 },
+    { "Peak2 Ratio", &ChainSettings::peakRatio2 },
+    { "Peak2 Attack", &ChainSettings::peakAttack2 },
+    { "Peak2 Release", &ChainSettings::peakRelease2 },
+    { "Peak3 Threshold", &ChainSettings::peakThreshold3 },
+    { "Peak3 Ratio", &ChainSettings::peakRatio3 },
+    { "Peak3 Attack", &ChainSettings::peakAttack3 },
+    { "Peak3 Release", &ChainSettings::peakRelease3 },
+    { "HighShelf Threshold", &ChainSettings::highShelfThreshold },
+    { "HighShelf Ratio", &ChainSettings::highShelfRatio },
+    { "HighShelf Attack", &ChainSettings::highShelfAttack },
+    { "HighShelf Release", &ChainSettings::highShelfRelease }
+}};
+
+ChainParameters::ChainParameters(juce::AudioProcessorValueTreeState& apvts)
+    : lowCutSlope(apvts.getRawParameterValue("LowCut Slope")),
+      highCutSlope(apvts.getRawParameterValue("HighCut Slope")),
+      topology(apvts.getRawParameterValue("Filter Topology")),
+      precision(apvts.getRawParameterValue("Filter Precision")),
+      phaseMode(apvts.getRawParameterValue("Phase Mode")),
+      bandDesign(apvts.getRawParameterValue("Band Design")),
+      oversamplingOrder(apvts.getRawParameterValue("Oversampling")),
+      oversamplingFilter(apvts.getRawParameterValue("Oversampling Filter")),
+      parallelChannels(apvts.getRawParameterValue("Parallel Channels")),
+      detectorSource(apvts.getRawParameterValue("Dynamics Detector"))
+{
+    for (size_t index = 0; index < floatParameters.size(); ++index)
+        floatValues[index] = apvts.getRawParameterValue(floatParameters[index].first);
+
+    for (size_t index = 0; index < routings.size(); ++index)
+        routings[index] = apvts.getRawParameterValue(juce::String(getBandName(static_cast<ChainPositions>(index)))
+                                                     + " Routing");
+}
+
+ChainSettings ChainParameters::load() const noexcept
+{
+    ChainSettings settings;
+
+    for (size_t index = 0; index < floatParameters.size(); ++index)
+        settings.*floatParameters[index].second = floatValues[index]->load();
+
+    settings.lowCutSlope = static_cast<Slope>(lowCutSlope->load());
+    settings.highCutSlope = static_cast<Slope>(highCutSlope->load());
+    settings.topology = static_cast<FilterTopology>(topology->load());
+    settings.precision = static_cast<FilterPrecision>(precision->load());
+    settings.phaseMode = static_cast<PhaseMode>(phaseMode->load());
+    settings.bandDesign = static_cast<BandDesign>(bandDesign->load());
+    settings.oversamplingOrder = static_cast<int>(oversamplingOrder->load());
+    settings.oversamplingFilter = static_cast<OversamplingFilter>(oversamplingFilter->load());
+    settings.parallelChannels = parallelChannels->load() > 0.5f;
+    settings.detectorSource = static_cast<DetectorSource>(detectorSource->load());
+
+    for (size_t index = 0; index < routings.size(); ++index)
+        settings.*bandFields[index].routing = static_cast<ChannelRouting>(routings[index]->load());
+
+    return settings;
+}
+
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    return ChainParameters(apvts).load();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout EQoonAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    juce::StringArray slopeSteep;
+    for (int i = 0; i < 4; ++i)
+    {
+        juce::String str;
+        str << (12 + i * 12);
+        str << " dB/oct";
+        slopeSteep.add(str);
+    }
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq",
+                                                           "LowCut Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
+                                                           20.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Quality",
+                                                           "LowCut Quality",
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                           1.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", slopeSteep, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LowShelf Freq",
+                                                           "LowShelf Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
+                                                           200.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LowShelf Gain",
+                                                           "LowShelf Gain",
+                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+                                                           0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LowShelf Quality",
+                                                           "LowShelf Quality",
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                           1.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Freq",
+                                                           "Peak1 Freq",
+                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.f, 0.3f),
+                                                           750.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Gain",
+                                                           "Peak1 Gain",
+                                                           -24.0f, 24.0f, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Quality",
+                                                           "Peak1 Quality",
+                                                           0.1f, 10.0f, 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Freq",
+                                                           "Peak2 Freq",
+                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.f, 0.3f),
+                                                           1500.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Gain",
+                                                           "Peak2 Gain",
+                                                           -24.0f, 24.0f, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Quality",
+                                                           "Peak2 Quality",
+                                                           0.1f, 10.0f, 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Freq",
+                                                           "Peak3 Freq",
+                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.f, 0.3f),
+                                                           3000.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Gain",
+                                                           "Peak3 Gain",
+                                                           -24.0f, 24.0f, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Quality",
+                                                           "Peak3 Quality",
+                                                           0.1f, 10.0f, 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HighShelf Freq",
+                                                           "HighShelf Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
+                                                           10000.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HighShelf Gain",
+                                                           "HighShelf Gain",
+                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+                                                           0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HighShelf Quality",
+                                                           "HighShelf Quality",
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                           1.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq",
+                                                           "HighCut Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f),
+                                                           20000.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Quality",
+                                                           "HighCut Quality",
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                           1.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", slopeSteep, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Topology", "Filter Topology",
+                                                            juce::StringArray { "Biquad", "SVF", "Parallel" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Precision", "Filter Precision",
+                                                            juce::StringArray { "32-bit", "64-bit" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Phase Mode", "Phase Mode",
+                                                            juce::StringArray { "Minimum Phase", "Linear Phase" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Band Design", "Band Design",
+                                                            juce::StringArray { "Bilinear", "Matched" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling",
+                                                            juce::StringArray { "1x", "2x", "4x", "8x" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling Filter", "Oversampling Filter",
+                                                            juce::StringArray { "Min Latency IIR", "Linear Phase FIR" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Parallel Channels", "Parallel Channels",
+                                                            juce::StringArray { "Single Thread", "Multithreaded" }, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Dynamics Detector", "Dynamics Detector",
+                                                            juce::StringArray { "Main Input", "Sidechain" }, 0));
+
+    for (int band = ChainPositions::LowShelf; band <= ChainPositions::HighShelf; ++band)
+    {
+        auto name = juce::String(getBandName(static_cast<ChainPositions>(band)));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(name + " Threshold", name + " Threshold",
+                                                               juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f),
+                                                               0.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(name + " Ratio", name + " Ratio",
+                                                               juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.4f),
+                                                               1.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(name + " Attack", name + " Attack",
+                                                               juce::NormalisableRange<float>(0.1f, 100.f, 0.1f, 0.4f),
+                                                               10.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(name + " Release", name + " Release",
+                                                               juce::NormalisableRange<float>(5.f, 1000.f, 1.f, 0.4f),
+                                                               150.f));
+    }
+
+    for (int band = ChainPositions::LowCut; band <= ChainPositions::HighCut; ++band)
+    {
+        auto parameterID = juce::String(getBandName(static_cast<ChainPositions>(band))) + " Routing";
+        layout.add(std::make_unique<juce::AudioParameterChoice>(parameterID, parameterID,
+                                                                juce::StringArray { "Stereo", "Left", "Right", "Mid", "Side" }, 0));
+    }
+
+    return layout;
+}
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new EQoonAudioProcessor();
+}
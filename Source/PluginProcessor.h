@@ -1,140 +1,331 @@
-#pragma once
-
-#include <JuceHeader.h>
-
-enum Slope
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
-
-struct ChainSettings
-{
-    float peakFreq1 { 0 }, peakGainInDecibels1 { 0 }, peakQuality1 {1.f};
-    float peakFreq2 { 0 }, peakGainInDecibels2 { 0 }, peakQuality2 {1.f};
-    float peakFreq3 { 0 }, peakGainInDecibels3 { 0 }, peakQuality3 {1.f};
-    float lowCutFreq { 0 }, highCutFreq { 0 }, lowCutQuality {1.f}, highCutQuality {1.f};
-    float lowShelfFreq { 0 }, lowShelfGainInDecibels { 0 }, lowShelfQuality {1.f};
-    float highShelfFreq { 0 }, highShelfGainInDecibels { 0 }, highShelfQuality {1.f};
-    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
-};
-
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-
-using Filter = juce::dsp::IIR::Filter<float>;
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, Filter, Filter, Filter, Filter, CutFilter>;
-
-enum ChainPositions
-{
-    LowCut,
-    LowShelf,
-    Peak1,
-    Peak2,
-    Peak3,
-    HighShelf,
-    HighCut
-};
-using Coefficients = Filter::CoefficientsPtr;
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate, int peakIndex);
-Coefficients makeLowShelfFilter(const ChainSettings& chainSettings, double sampleRate);
-Coefficients makeHighShelfFilter(const ChainSettings& chainSettings, double sampleRate);
-
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
-
-template<int Index, typename ChainType>
-void update(ChainType& chain, const Coefficients& coefficients)
-{
-    auto& filter = chain.template get<Index>();
-    updateCoefficients(filter.coefficients, coefficients);
-    chain.template setBypassed<Index>(false);
-}
-
-template<typename ChainType>
-void updateCutFilter(ChainType& chain, const Coefficients& coefficients, Slope slope)
-{
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
-
-    switch (slope)
-    {
-        case Slope_48:
-            update<3>(chain, coefficients);
-            [[fallthrough]];
-        case Slope_36:
-            update<2>(chain, coefficients);
-            [[fallthrough]];
-        case Slope_24:
-            update<1>(chain, coefficients);
-            [[fallthrough]];
-        case Slope_12:
-            update<0>(chain, coefficients);
-            break;
-    }
-}
-
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    auto coefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
-        chainSettings.lowCutFreq, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
-    return coefficients[0];
-}
-
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    auto coefficients =  juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
-        chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
-    return coefficients[0];
-
-}
-
-class EQoonAudioProcessor  : public juce::AudioProcessor
-{
-public:
-    EQoonAudioProcessor();
-    ~EQoonAudioProcessor() override;
-
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
-
-private:
-    MonoChain leftChain, rightChain;
-
-    void updatePeakFilters(const ChainSettings& chainSettings);
-    void updateLowShelfFilter(const ChainSettings& chainSettings);
-    void updateHighShelfFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
-    void updateFilters();
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQoonAudioProcessor)
-};
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQoonDsp.h"
+#include "TripleBuffer.h"
+#include "RealtimeSafety.h"
+#include "SampleFifo.h"
+#include "LinearPhaseFir.h"
+#include "BandDynamics.h"
+#include "ParameterEventQueue.h"
+#include "ProcessLoadMeter.h"
+
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+
+// The raw values behind every ChainSettings field, looked up once. Loading through it
+// never builds a String or searches the parameter list, so the audio thread may use it.
+class ChainParameters
+{
+public:
+    explicit ChainParameters(juce::AudioProcessorValueTreeState& apvts);
+
+    ChainSettings load() const noexcept;
+
+private:
+    std::array<std::atomic<float>*, 39> floatValues {};
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* topology;
+    std::atomic<float>* precision;
+    std::atomic<float>* phaseMode;
+    std::atomic<float>* bandDesign;
+    std::atomic<float>* oversamplingOrder;
+    std::atomic<float>* oversamplingFilter;
+    std::atomic<float>* parallelChannels;
+    std::atomic<float>* detectorSource;
+    std::array<std::atomic<float>*, 7> routings {};
+};
+
+/*
+    Every oversampling stage for one sample type, built up front so the audio thread can
+    switch factor and filter without allocating. Stages run with integer latency, so the
+    delay they report compensates them exactly.
+*/
+template <typename SampleType>
+class Oversamplers
+{
+public:
+    static constexpr int maxOrder = 3;
+
+    void prepare(size_t numChannels, size_t maximumBlockSize)
+    {
+        for (int order = 1; order <= maxOrder; ++order)
+        {
+            for (auto filter : { OversamplingFilter::minimumLatency, OversamplingFilter::linearPhase })
+            {
+                auto filterType = filter == OversamplingFilter::linearPhase
+                                    ? juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple
+                                    : juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR;
+                auto index = getIndex(order, filter);
+
+                stages[index] = std::make_unique<juce::dsp::Oversampling<SampleType>>(numChannels, (size_t) order,
+                                                                                      filterType, true, true);
+                stages[index]->initProcessing(maximumBlockSize);
+                latencies[index] = juce::roundToInt(stages[index]->getLatencyInSamples());
+            }
+        }
+    }
+
+    void release()
+    {
+        for (auto& stage : stages)
+            stage.reset();
+
+        latencies.fill(0);
+    }
+
+    void reset() noexcept
+    {
+        for (auto& stage : stages)
+            if (stage != nullptr)
+                stage->reset();
+    }
+
+    // Null when the settings don't oversample or nothing is prepared.
+    juce::dsp::Oversampling<SampleType>* get(const ChainSettings& settings) const noexcept
+    {
+        if (settings.oversamplingOrder <= 0)
+            return nullptr;
+
+        return stages[getIndex(settings.oversamplingOrder, settings.oversamplingFilter)].get();
+    }
+
+    // In host rate samples.
+    int getLatencySamples(const ChainSettings& settings) const noexcept
+    {
+        if (settings.oversamplingOrder <= 0)
+            return 0;
+
+        return latencies[getIndex(settings.oversamplingOrder, settings.oversamplingFilter)];
+    }
+
+private:
+    static constexpr size_t numStages = 2 * maxOrder;
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, numStages> stages;
+    std::array<int, numStages> latencies {};
+
+    static size_t getIndex(int order, OversamplingFilter filter) noexcept
+    {
+        return (size_t) (2 * (juce::jlimit(1, maxOrder, order) - 1) + (filter == OversamplingFilter::linearPhase ? 1 : 0));
+    }
+};
+
+class EQoonAudioProcessor  : public juce::AudioProcessor,
+                             private juce::AudioProcessorValueTreeState::Listener,
+                             private juce::TimeSliceClient,
+                             private juce::AsyncUpdater
+{
+public:
+    EQoonAudioProcessor();
+    ~EQoonAudioProcessor() override;
+
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    void reset() override;
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
+
+    FilterSnapshot getLatestSnapshot() const;
+    juce::uint32 getLatestSnapshotVersion() const { return latestSnapshotVersion.load(); }
+
+    // The background thread that designs the filters, shared by every EQoon instance in
+    // the process. Editors run their own non-real-time work on it too.
+    juce::TimeSliceThread& getDesignThread() { return *designThread; }
+
+    // Audio for the analyzer, mixed to mono, taken before and after the filters. The
+    // audio thread only fills a FIFO while an editor has switched its tap on, so
+    // headless renders never pay for it.
+    void setAnalyzerTaps(bool preEq, bool postEq);
+    SampleFifo& getPreEqFifo() { return preEqFifo; }
+    SampleFifo& getPostEqFifo() { return postEqFifo; }
+
+    // Sample-accurate automation. Queues a change of the parameter at parameterIndex, in
+    // getParameters() order, to normalisedValue at sampleOffset of the next block. Call
+    // from the audio thread before processBlock(), instead of setting the parameter, for
+    // every point of a ramp including the last. Returns false if the queue is full or
+    // the index is out of range.
+    bool addParameterEvent(int parameterIndex, int sampleOffset, float normalisedValue);
+
+    // The share of the real-time budget processBlock() takes, split into its stages, with
+    // totals since prepareToPlay(). Reads a few atomics, so any thread may poll it at any
+    // rate; the audio thread never waits for a reader.
+    ProcessLoadMeter::Reading getProcessLoad() const noexcept { return loadMeter.getReading(); }
+
+private:
+    // Shared by every EQoon instance in the process; each one polls its own dirty bits.
+    struct DesignThread : juce::TimeSliceThread
+    {
+        DesignThread() : juce::TimeSliceThread("EQoon Designer") { startThread(); }
+        ~DesignThread() override { stopThread(1000); }
+    };
+
+    static constexpr int designIntervalMs = 2;
+
+    FilterBanks<float> floatBanks;
+    FilterBanks<double> doubleBanks;
+
+    // A state recall designs the whole preset off the audio thread and publishes it at
+    // once; the audio thread swaps it in, crossfading over recallFadeSeconds from the
+    // banks it ran until then, which keep filtering a copy of the input meanwhile.
+    static constexpr double recallFadeSeconds = 0.02;
+    FilterBanks<float> floatFadingBanks;
+    FilterBanks<double> doubleFadingBanks;
+    juce::AudioBuffer<float> floatRecallInput;
+    juce::AudioBuffer<double> doubleRecallInput;
+    juce::uint32 appliedRecallCount = 0;
+    int recallFadeLength = 0, recallFadeRemaining = 0;
+
+    // Only the stages for the host's precision are prepared. They run around the banks in
+    // minimum phase mode; the linear phase FIR runs at the host rate.
+    Oversamplers<float> floatOversamplers;
+    Oversamplers<double> doubleOversamplers;
+
+    // Buses wider than one channel group can share the groups out to a few workers while
+    // "Parallel Channels" is on. Shorter blocks stay on the audio thread, where handing
+    // them over would cost more than it saves; so do the sub-blocks of a glide.
+    static constexpr int maxChannelWorkers = 3;
+    static constexpr size_t minParallelBlockSize = 256;
+
+    // The pool only exists while the processor is prepared with the parameter on, so
+    // instances that don't share their groups out keep no real-time threads around. The
+    // design and message threads create and destroy it in updateChannelWorkers(), under
+    // channelWorkersLock. The audio thread marks channelWorkersInUse before it reads
+    // audioChannelWorkers, and a pool is only destroyed once it is unpublished and unmarked.
+    juce::CriticalSection channelWorkersLock;
+    std::unique_ptr<ChannelWorkerPool> channelWorkers;
+    int numChannelWorkers = 0; // For the prepared layout
+    std::atomic<ChannelWorkerPool*> audioChannelWorkers { nullptr };
+    std::atomic<bool> channelWorkersInUse { false };
+
+    // Between prepareToPlay() and releaseResources(), under designLock.
+    bool channelWorkersPrepared = false;
+
+    // The audio thread glides from the design it runs towards the latest published one,
+    // through the same SnapshotGlide as EQoonEngine, on a control grid that doesn't
+    // depend on the host block size. The SVF banks additionally ramp their tuning across
+    // each interval, so they glide at audio rate.
+    SnapshotGlide glide;
+
+    // The dynamic bands' detectors run over each host block before the filters; their
+    // envelopes are sampled on the control grid and change the bands' gains through
+    // the same fast redesign as a glide. Minimum phase only: the linear phase kernel is
+    // designed far too rarely to follow them.
+    BandDynamics dynamics;
+    bool dynamicsActive = false;
+
+    // Consecutive silent input samples of each channel, up to the end of the last block.
+    // A channel whose input has been silent for the whole tail, so its filter state has
+    // decayed by 100 dB, is idle: its channel group skips the filters. Once every channel
+    // is, the block passes straight through and nothing runs at all.
+    static constexpr float silenceThreshold = 1.0e-8f; // The same as JUCE_SNAP_TO_ZERO
+    std::vector<int> silentSamples;
+    bool chainIdle = false;
+
+    ChainParameters chainParameters { apvts };
+
+    // Automation points inside the coming block. Offline renders split the block at
+    // them, on the control grid, and design each part with the values due by its start;
+    // every split only costs what a shorter host block would. In real time the design
+    // thread couldn't follow a split, so they all apply before the block as usual.
+    ParameterEventQueue parameterEvents;
+
+    // One bit per ChainPositions entry, set by parameter listeners on whatever thread
+    // changed the value and consumed by publishSnapshot().
+    std::atomic<juce::uint32> dirtyBands { allBandFlags };
+
+    juce::SharedResourcePointer<DesignThread> designThread;
+
+    // Times every processBlock() and its stages for getProcessLoad().
+    ProcessLoadMeter loadMeter;
+
+    // About 170 ms at 192 kHz, so the analyzer can miss a few refreshes without gaps.
+    static constexpr int analyzerFifoSize = 1 << 15;
+    SampleFifo preEqFifo { analyzerFifoSize }, postEqFifo { analyzerFifoSize };
+    std::atomic<bool> preEqTapEnabled { false }, postEqTapEnabled { false };
+
+    juce::SpinLock designLock, latestSnapshotLock;
+    std::atomic<bool> recallInProgress { false };
+    FilterSnapshot designedSnapshot, latestSnapshot;
+    std::atomic<juce::uint32> latestSnapshotVersion { 0 };
+    TripleBuffer<FilterSnapshot> snapshots;
+
+    // Designed from designedSnapshot on the design thread, under designLock. Kernels are
+    // redesigned at most every kernelDesignIntervalMs while bands move; the convolution
+    // crossfades to each one. Offline, the audio thread designs every version itself.
+    static constexpr double kernelDesignIntervalMs = 50.0;
+    LinearPhaseFir linearPhase;
+    juce::uint32 kernelVersion = 0;
+    double lastKernelDesignMs = 0.0;
+    int reportedLatencySamples = 0;
+    std::atomic<double> tailLengthSeconds { 0.0 };
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void markAllBandsDirty();
+
+    int useTimeSlice() override;
+    void publishSnapshot();
+    void updateLinearPhaseKernel();
+    void updateChannelWorkers();
+    void designInline();
+    void designLinearPhaseKernel(LinearPhaseFir::KernelLoad load = LinearPhaseFir::KernelLoad::background);
+    void handleAsyncUpdate() override;
+    void updateLatency();
+    int getLatencyForSettings(const ChainSettings& settings) const;
+    void applyPendingSnapshot();
+    bool usesDoubleBanks(const FilterSnapshot& snapshot) const;
+    void applyToActiveBanks(const FilterSnapshot& snapshot);
+    void advanceDynamics(int hostSample);
+    void jumpToPendingSnapshot();
+    void startRecallFade(const FilterSnapshot& target);
+    void recallState(const juce::HashMap<juce::uint32, float>& values, const juce::ValueTree& properties);
+
+    template <typename SampleType>
+    bool updateIdleChannels(const juce::dsp::AudioBlock<SampleType>& block);
+
+    template <typename SampleType>
+    void runDetectors(juce::AudioBuffer<SampleType>& buffer, const juce::dsp::AudioBlock<SampleType>& mainBlock);
+
+    template <typename SampleType>
+    void processSegments(juce::AudioBuffer<SampleType>& buffer);
+
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    template <typename SampleType>
+    void processFilters(const juce::dsp::AudioBlock<SampleType>& block);
+
+    template <typename SampleType>
+    void processBanks(juce::dsp::AudioBlock<SampleType> subBlock);
+
+    Oversamplers<float>& getOversamplers(float) noexcept    { return floatOversamplers; }
+    Oversamplers<double>& getOversamplers(double) noexcept  { return doubleOversamplers; }
+    juce::AudioBuffer<float>& getRecallInput(float) noexcept     { return floatRecallInput; }
+    juce::AudioBuffer<double>& getRecallInput(double) noexcept   { return doubleRecallInput; }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQoonAudioProcessor)
+};
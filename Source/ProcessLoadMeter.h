@@ -0,0 +1,190 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    How much of the real-time budget one processor spends, and on what, measured the
+    way juce::AudioProcessLoadMeasurer does it: the time each block takes over the
+    audio's duration, smoothed over the last few hundred milliseconds.
+
+    The audio thread times each block, and the stages within it, with the high
+    resolution tick counter and publishes the results through lock-free atomics that
+    only it writes. It never waits or allocates (AudioProcessLoadMeasurer guards its
+    state with a spin lock), and any thread can read the meter at any time. Each value
+    is whole, but one reading may mix values from consecutive blocks.
+*/
+class ProcessLoadMeter
+{
+public:
+    enum Stage
+    {
+        coefficients, // Applying new designs: snapshots, glides, dynamics, inline designs
+        analysis,     // The analyzer taps and the dynamics detectors
+        filters,      // The rest: filters, oversampling, linear phase and the copying
+        numStages
+    };
+
+    static const char* getStageName(Stage stage) noexcept
+    {
+        switch (stage)
+        {
+            case coefficients: return "coefficients";
+            case analysis:     return "analysis";
+            case filters:      return "filters";
+            case numStages:
+            default:           return "";
+        }
+    }
+
+    struct Reading
+    {
+        double load = 0.0;     // Smoothed share of the real-time budget; past 1 can't keep up
+        double peakLoad = 0.0; // Of the heaviest block since prepare()
+        std::array<double, numStages> stageLoads {};   // Smoothed parts of load
+        std::array<double, numStages> stageSeconds {}; // Totals since prepare()
+        double processSeconds = 0.0; // Spent in blocks since prepare()
+        double audioSeconds = 0.0;   // Of audio in them
+        juce::int64 numBlocks = 0;
+        juce::int64 numOverruns = 0; // Blocks that took longer than the audio they held
+    };
+
+    // Starts again from zero. Not while a block is being timed.
+    void prepare(double sampleRate) noexcept
+    {
+        secondsPerSample = sampleRate > 0.0 ? 1.0 / sampleRate : 0.0;
+        secondsPerTick = 1.0 / (double) juce::Time::getHighResolutionTicksPerSecond();
+        stageTicks.fill(0);
+
+        for (auto* value : { &load, &peakLoad, &processSeconds, &audioSeconds })
+            value->store(0.0, std::memory_order_relaxed);
+
+        for (size_t stage = 0; stage < numStages; ++stage)
+        {
+            stageLoads[stage].store(0.0, std::memory_order_relaxed);
+            stageSeconds[stage].store(0.0, std::memory_order_relaxed);
+        }
+
+        numBlocks.store(0, std::memory_order_relaxed);
+        numOverruns.store(0, std::memory_order_relaxed);
+    }
+
+    // Times one block of numSamples at the prepared rate, on the audio thread.
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(ProcessLoadMeter& meterToUse, int numSamplesToTime) noexcept
+            : meter(meterToUse), numSamples(numSamplesToTime), start(juce::Time::getHighResolutionTicks())
+        {
+            meter.stageTicks.fill(0);
+        }
+
+        ~ScopedBlock() noexcept
+        {
+            meter.finishBlock(juce::Time::getHighResolutionTicks() - start, numSamples);
+        }
+
+    private:
+        ProcessLoadMeter& meter;
+        int numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    // Adds its lifetime to a stage of the block being timed. Stages don't nest, and
+    // filters needn't be timed: it is what the block spent outside the others.
+    class ScopedStage
+    {
+    public:
+        ScopedStage(ProcessLoadMeter& meterToUse, Stage stageToTime) noexcept
+            : meter(meterToUse), stage((size_t) stageToTime), start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedStage() noexcept
+        {
+            meter.stageTicks[stage] += juce::Time::getHighResolutionTicks() - start;
+        }
+
+    private:
+        ProcessLoadMeter& meter;
+        size_t stage;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    Reading getReading() const noexcept
+    {
+        Reading reading;
+        reading.load = load.load(std::memory_order_relaxed);
+        reading.peakLoad = peakLoad.load(std::memory_order_relaxed);
+        reading.processSeconds = processSeconds.load(std::memory_order_relaxed);
+        reading.audioSeconds = audioSeconds.load(std::memory_order_relaxed);
+        reading.numBlocks = numBlocks.load(std::memory_order_relaxed);
+        reading.numOverruns = numOverruns.load(std::memory_order_relaxed);
+
+        for (size_t stage = 0; stage < numStages; ++stage)
+        {
+            reading.stageLoads[stage] = stageLoads[stage].load(std::memory_order_relaxed);
+            reading.stageSeconds[stage] = stageSeconds[stage].load(std::memory_order_relaxed);
+        }
+
+        return reading;
+    }
+
+private:
+    static_assert(std::atomic<double>::is_always_lock_free, "The audio thread mustn't lock to publish");
+
+    static constexpr double smoothingSeconds = 0.3;
+
+    std::atomic<double> load { 0.0 }, peakLoad { 0.0 }, processSeconds { 0.0 }, audioSeconds { 0.0 };
+    std::array<std::atomic<double>, numStages> stageLoads {}, stageSeconds {};
+    std::atomic<juce::int64> numBlocks { 0 }, numOverruns { 0 };
+
+    // Audio thread only.
+    double secondsPerSample = 0.0, secondsPerTick = 0.0;
+    std::array<juce::int64, numStages> stageTicks {};
+
+    // Only the audio thread writes, so read-modify-write needs no atomic operation.
+    static void add(std::atomic<double>& value, double amount) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void smooth(std::atomic<double>& value, double target, double amount) noexcept
+    {
+        add(value, amount * (target - value.load(std::memory_order_relaxed)));
+    }
+
+    void finishBlock(juce::int64 ticks, int numSamples) noexcept
+    {
+        auto duration = numSamples * secondsPerSample;
+        if (duration <= 0.0)
+            return;
+
+        stageTicks[filters] = juce::jmax((juce::int64) 0, ticks - stageTicks[coefficients] - stageTicks[analysis]);
+
+        // Time based rather than per block, so every block size settles as quickly.
+        auto amount = 1.0 - std::exp(-duration / smoothingSeconds);
+        auto seconds = (double) ticks * secondsPerTick;
+        auto blockLoad = seconds / duration;
+
+        smooth(load, blockLoad, amount);
+        peakLoad.store(juce::jmax(peakLoad.load(std::memory_order_relaxed), blockLoad), std::memory_order_relaxed);
+        add(processSeconds, seconds);
+        add(audioSeconds, duration);
+
+        for (size_t stage = 0; stage < numStages; ++stage)
+        {
+            auto stageSecondsInBlock = (double) stageTicks[stage] * secondsPerTick;
+            smooth(stageLoads[stage], stageSecondsInBlock / duration, amount);
+            add(stageSeconds[stage], stageSecondsInBlock);
+        }
+
+        numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (seconds > duration)
+            numOverruns.store(numOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,296 @@
+#include "RealtimeSafety.h"
+
+#if EQOON_RT_CHECKS
+
+#include <new>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <cxxabi.h>
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace RealtimeSafety
+{
+    // Constant-initialised, so touching it from inside malloc never runs an initialiser.
+    static thread_local int regionDepth = 0;
+
+    struct CallSite
+    {
+        std::atomic<void*> address { nullptr };
+        std::atomic<int> kind { 0 };
+        std::atomic<int> count { 0 };
+    };
+
+    static constexpr size_t maxCallSites = 64;
+    static std::array<CallSite, maxCallSites> callSites;
+    static std::atomic<int> numViolations { 0 }, numUnrecordedCallSites { 0 };
+
+    static void record(Violation kind, void* address) noexcept
+    {
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+        for (auto& site : callSites)
+        {
+            auto current = site.address.load(std::memory_order_acquire);
+
+            if (current == nullptr)
+            {
+                if (site.address.compare_exchange_strong(current, address, std::memory_order_acq_rel))
+                {
+                    site.kind.store((int) kind, std::memory_order_relaxed);
+                    site.count.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            if (current == address && site.kind.load(std::memory_order_relaxed) == (int) kind)
+            {
+                site.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        numUnrecordedCallSites.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static inline void check(Violation kind, void* address) noexcept
+    {
+        if (regionDepth > 0)
+        {
+            // Anything the recording itself calls mustn't be reported again.
+            --regionDepth;
+            record(kind, address);
+            ++regionDepth;
+        }
+    }
+
+    ScopedRegion::ScopedRegion() noexcept
+    {
+        ++regionDepth;
+    }
+
+    ScopedRegion::~ScopedRegion() noexcept
+    {
+        --regionDepth;
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load();
+    }
+
+    static juce::String describeAddress(void* address)
+    {
+        auto description = juce::String::toHexString((juce::pointer_sized_int) address);
+
+       #if JUCE_LINUX || JUCE_MAC
+        Dl_info info;
+        if (dladdr(address, &info) != 0 && info.dli_sname != nullptr)
+        {
+            int status = 0;
+            auto* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            description << " " << (status == 0 && demangled != nullptr ? demangled : info.dli_sname)
+                        << " +" << (int) ((char*) address - (char*) info.dli_saddr);
+            std::free(demangled);
+        }
+       #endif
+
+        return description;
+    }
+
+    juce::String getReport()
+    {
+        static const char* const kindNames[] = { "allocation", "deallocation", "lock" };
+        juce::String report;
+
+        for (auto& site : callSites)
+        {
+            auto address = site.address.load();
+            if (address == nullptr)
+                break;
+
+            report << kindNames[site.kind.load()] << " x" << site.count.load()
+                   << " from " << describeAddress(address) << juce::newLine;
+        }
+
+        if (auto unrecorded = numUnrecordedCallSites.load())
+            report << unrecorded << " more violations from call sites past the first "
+                   << (int) maxCallSites << juce::newLine;
+
+        return report;
+    }
+
+    void reset() noexcept
+    {
+        for (auto& site : callSites)
+        {
+            site.count.store(0);
+            site.kind.store(0);
+            site.address.store(nullptr);
+        }
+
+        numViolations.store(0);
+        numUnrecordedCallSites.store(0);
+    }
+}
+
+//==============================================================================
+// The replacements. Each records its caller, then forwards to the real function.
+
+#if JUCE_LINUX
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+static void* allocate(size_t size) noexcept                          { return __libc_malloc(size); }
+static void* allocateAligned(size_t size, size_t alignment) noexcept { return __libc_memalign(alignment, size); }
+static void deallocate(void* pointer) noexcept                       { __libc_free(pointer); }
+
+extern "C" void* malloc(size_t size)
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, __builtin_return_address(0));
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, __builtin_return_address(0));
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, __builtin_return_address(0));
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer)
+{
+    if (pointer != nullptr)
+        RealtimeSafety::check(RealtimeSafety::Violation::deallocation, __builtin_return_address(0));
+
+    __libc_free(pointer);
+}
+#else
+static void* allocate(size_t size) noexcept     { return std::malloc(size); }
+static void deallocate(void* pointer) noexcept  { std::free(pointer); }
+
+static void* allocateAligned(size_t size, size_t alignment) noexcept
+{
+   #if JUCE_WINDOWS
+    return _aligned_malloc(size, alignment);
+   #else
+    void* pointer = nullptr;
+    return posix_memalign(&pointer, juce::jmax(alignment, sizeof(void*)), size) == 0 ? pointer : nullptr;
+   #endif
+}
+#endif
+
+#if JUCE_LINUX || JUCE_MAC
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    using MutexLockFunction = int (*)(pthread_mutex_t*);
+    static std::atomic<MutexLockFunction> next { nullptr };
+
+    auto function = next.load(std::memory_order_acquire);
+    if (function == nullptr)
+    {
+        function = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        next.store(function, std::memory_order_release);
+    }
+
+    RealtimeSafety::check(RealtimeSafety::Violation::lock, __builtin_return_address(0));
+    return function(mutex);
+}
+#endif
+
+static void* allocateOrThrow(size_t size, void* caller)
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, caller);
+
+    if (auto* pointer = allocate(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+static void release(void* pointer, void* caller) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeSafety::check(RealtimeSafety::Violation::deallocation, caller);
+
+    deallocate(pointer);
+}
+
+static void* allocateAlignedOrThrow(size_t size, std::align_val_t alignment, void* caller)
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, caller);
+
+    if (auto* pointer = allocateAligned(size == 0 ? 1 : size, static_cast<size_t>(alignment)))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+static void releaseAligned(void* pointer, void* caller) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeSafety::check(RealtimeSafety::Violation::deallocation, caller);
+
+   #if JUCE_WINDOWS
+    _aligned_free(pointer);
+   #else
+    deallocate(pointer);
+   #endif
+}
+
+#define EQOON_CALLER __builtin_return_address(0)
+
+void* operator new(size_t size)                                           { return allocateOrThrow(size, EQOON_CALLER); }
+void* operator new[](size_t size)                                         { return allocateOrThrow(size, EQOON_CALLER); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, EQOON_CALLER);
+    return allocate(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeSafety::check(RealtimeSafety::Violation::allocation, EQOON_CALLER);
+    return allocate(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer) noexcept                              { release(pointer, EQOON_CALLER); }
+void operator delete[](void* pointer) noexcept                            { release(pointer, EQOON_CALLER); }
+void operator delete(void* pointer, size_t) noexcept                      { release(pointer, EQOON_CALLER); }
+void operator delete[](void* pointer, size_t) noexcept                    { release(pointer, EQOON_CALLER); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept       { release(pointer, EQOON_CALLER); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept     { release(pointer, EQOON_CALLER); }
+
+// Over-aligned types.
+void* operator new(size_t size, std::align_val_t alignment)               { return allocateAlignedOrThrow(size, alignment, EQOON_CALLER); }
+void* operator new[](size_t size, std::align_val_t alignment)             { return allocateAlignedOrThrow(size, alignment, EQOON_CALLER); }
+void operator delete(void* pointer, std::align_val_t) noexcept            { releaseAligned(pointer, EQOON_CALLER); }
+void operator delete[](void* pointer, std::align_val_t) noexcept          { releaseAligned(pointer, EQOON_CALLER); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept    { releaseAligned(pointer, EQOON_CALLER); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept  { releaseAligned(pointer, EQOON_CALLER); }
+
+#undef EQOON_CALLER
+
+#else
+
+namespace RealtimeSafety
+{
+    int getNumViolations() noexcept  { return 0; }
+    juce::String getReport()         { return {}; }
+    void reset() noexcept            {}
+}
+
+#endif
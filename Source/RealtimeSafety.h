@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Build with EQOON_RT_CHECKS=1 to catch the audio thread allocating, freeing or taking a
+// mutex. The benchmark's Debug configuration turns it on for its --rt-check run.
+#ifndef EQOON_RT_CHECKS
+ #define EQOON_RT_CHECKS 0
+#endif
+
+/*
+    Real-time safety checks for the audio callback.
+
+    A ScopedRegion marks the calling thread as real-time for its lifetime. In a checking
+    build, global operator new and delete, malloc, calloc, realloc and free (glibc) and
+    pthread_mutex_lock are replaced by versions that record every call made inside a
+    region, keyed by the address that called them. Recording never allocates or locks,
+    so the checks don't disturb what they measure.
+
+    The replacements are only reliable in an executable, where the linker routes every
+    call to them; in a plugin loaded by a host the host's allocator may win. Without
+    EQOON_RT_CHECKS all of this compiles to nothing.
+*/
+namespace RealtimeSafety
+{
+    enum class Violation
+    {
+        allocation,
+        deallocation,
+        lock
+    };
+
+    constexpr bool isEnabled() noexcept
+    {
+        return EQOON_RT_CHECKS != 0;
+    }
+
+   #if EQOON_RT_CHECKS
+    struct ScopedRegion
+    {
+        ScopedRegion() noexcept;
+        ~ScopedRegion() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRegion)
+    };
+   #else
+    struct ScopedRegion
+    {
+        ScopedRegion() noexcept {}
+    };
+   #endif
+
+    // Total violations recorded since the last reset().
+    int getNumViolations() noexcept;
+
+    // One line per distinct call site: kind, count and the symbol that made the call,
+    // where the platform can name it. Allocates, so call it outside any region.
+    juce::String getReport();
+
+    void reset() noexcept;
+}
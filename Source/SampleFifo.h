@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Wait-free single-producer single-consumer FIFO of mono float samples, used to carry
+    audio from the audio thread to the analyzer.
+
+    The storage is allocated once in the constructor and never resized, so neither side
+    ever allocates or waits; juce::AbstractFifo only publishes its read and write
+    positions through atomics. When the consumer falls behind, push() drops what
+    doesn't fit instead of overwriting samples the consumer may be reading.
+*/
+class SampleFifo
+{
+public:
+    explicit SampleFifo(int capacity) : fifo(capacity), samples((size_t) capacity)
+    {
+    }
+
+    // Producer side. Mixes the channels down to mono while copying.
+    template <typename SampleType>
+    void push(const juce::dsp::AudioBlock<const SampleType>& block) noexcept
+    {
+        if (block.getNumChannels() == 0)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite((int) block.getNumSamples(), start1, size1, start2, size2);
+        mixDown(block, 0, samples.data() + start1, size1);
+        mixDown(block, (size_t) size1, samples.data() + start2, size2);
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    // Consumer side. Returns the number of samples copied into destination.
+    int pull(float* destination, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+        std::copy_n(samples.data() + start1, size1, destination);
+        std::copy_n(samples.data() + start2, size2, destination + size1);
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    // Consumer side. Throws away everything queued, e.g. audio pushed before a new
+    // consumer attached.
+    void discard() noexcept
+    {
+        fifo.finishedRead(fifo.getNumReady());
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<float> samples;
+
+    template <typename SampleType>
+    static void mixDown(const juce::dsp::AudioBlock<const SampleType>& block, size_t offset,
+                        float* destination, int numSamples) noexcept
+    {
+        auto numChannels = block.getNumChannels();
+        auto gain = 1.f / (float) numChannels;
+
+        auto* first = block.getChannelPointer(0) + offset;
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] = gain * (float) first[i];
+
+        for (size_t channel = 1; channel < numChannels; ++channel)
+        {
+            auto* source = block.getChannelPointer(channel) + offset;
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] += gain * (float) source[i];
+        }
+    }
+};
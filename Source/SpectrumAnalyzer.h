@@ -0,0 +1,132 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleFifo.h"
+
+/*
+    The consumer side of the analyzer: drains a SampleFifo and keeps the magnitude
+    spectrum of the most recent window of samples, in dB relative to a full scale sine.
+
+    A Hann-windowed FFT runs every fftSize / overlap samples. Each frame is blended into
+    the running level with the averaging weight, and the peak level follows the maximum
+    of the running level and falls back at peakDecayDecibelsPerSecond.
+
+    Everything here runs on one non-real-time thread; setSettings() allocates.
+*/
+class SpectrumAnalyzer
+{
+public:
+    struct Settings
+    {
+        int fftOrder = 12;
+        int overlap = 4;
+        float averaging = 0.7f;
+        bool peakHold = true;
+        float peakDecayDecibelsPerSecond = 12.f;
+    };
+
+    static constexpr float minusInfinityDb = -120.f;
+
+    SpectrumAnalyzer()
+    {
+        setSettings({});
+    }
+
+    void setSettings(const Settings& newSettings)
+    {
+        settings = newSettings;
+        settings.fftOrder = juce::jlimit(8, 15, settings.fftOrder);
+        settings.overlap = juce::jlimit(1, 16, settings.overlap);
+        settings.averaging = juce::jlimit(0.f, 0.99f, settings.averaging);
+
+        auto fftSize = getFftSize();
+        fft = std::make_unique<juce::dsp::FFT>(settings.fftOrder);
+        window.resize((size_t) fftSize);
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) fftSize,
+                                                                 juce::dsp::WindowingFunction<float>::hann, true);
+        history.resize((size_t) fftSize);
+        incoming.resize((size_t) fftSize);
+        fftData.resize(2 * (size_t) fftSize);
+        level.resize((size_t) getNumBins());
+        peakLevel.resize((size_t) getNumBins());
+        reset();
+    }
+
+    const Settings& getSettings() const noexcept      { return settings; }
+    int getFftSize() const noexcept                   { return 1 << settings.fftOrder; }
+    int getNumBins() const noexcept                   { return getFftSize() / 2 + 1; }
+    const std::vector<float>& getLevel() const noexcept      { return level; }
+    const std::vector<float>& getPeakLevel() const noexcept  { return peakLevel; }
+
+    void reset()
+    {
+        std::fill(history.begin(), history.end(), 0.f);
+        std::fill(level.begin(), level.end(), minusInfinityDb);
+        std::fill(peakLevel.begin(), peakLevel.end(), minusInfinityDb);
+        historyPosition = 0;
+        samplesUntilFrame = getHopSize();
+    }
+
+    // Pulls everything queued and analyses each completed hop. Returns true if the
+    // spectrum changed.
+    bool process(SampleFifo& fifo, double sampleRate)
+    {
+        auto changed = false;
+        auto fftSize = getFftSize();
+
+        while (auto numPulled = fifo.pull(incoming.data(), (int) incoming.size()))
+        {
+            for (int i = 0; i < numPulled; ++i)
+            {
+                history[(size_t) historyPosition] = incoming[(size_t) i];
+                historyPosition = (historyPosition + 1) & (fftSize - 1);
+
+                if (--samplesUntilFrame == 0)
+                {
+                    analyseFrame(sampleRate);
+                    samplesUntilFrame = getHopSize();
+                    changed = true;
+                }
+            }
+        }
+
+        return changed;
+    }
+
+private:
+    Settings settings;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> window, history, incoming, fftData, level, peakLevel;
+    int historyPosition = 0, samplesUntilFrame = 0;
+
+    int getHopSize() const noexcept
+    {
+        return juce::jmax(1, getFftSize() / settings.overlap);
+    }
+
+    void analyseFrame(double sampleRate)
+    {
+        auto fftSize = getFftSize();
+        auto oldest = history.begin() + historyPosition;
+
+        // Oldest sample first.
+        std::copy(oldest, history.end(), fftData.begin());
+        std::copy(history.begin(), oldest, fftData.begin() + (history.end() - oldest));
+        juce::FloatVectorOperations::multiply(fftData.data(), window.data(), fftSize);
+        fft->performFrequencyOnlyForwardTransform(fftData.data());
+
+        // The window has unit mean, so a full scale sine peaks at fftSize / 2.
+        auto scale = 2.f / (float) fftSize;
+        auto decay = settings.peakHold ? settings.peakDecayDecibelsPerSecond * (float) (getHopSize() / sampleRate)
+                                       : 0.f;
+
+        for (size_t bin = 0; bin < level.size(); ++bin)
+        {
+            auto frameLevel = juce::Decibels::gainToDecibels(fftData[bin] * scale, minusInfinityDb);
+            level[bin] = settings.averaging * level[bin] + (1.f - settings.averaging) * frameLevel;
+
+            if (settings.peakHold)
+                peakLevel[bin] = juce::jmax(level[bin], peakLevel[bin] - decay);
+        }
+    }
+};
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "InterleavedBuffer.h"
+
+/*
+    The state-variable counterpart of BiquadBank: up to MaxSections topology-preserving
+    transform SVFs run as one cascade, one channel per SIMD lane, with the same section
+    compaction and grouped kernels.
+
+    Each section is described by g = tan(pi * f / fs), the damping k and the mix m0, m1,
+    m2 of its input, band-pass and low-pass outputs (Simper's linear trapezoidal form).
+    The state holds the integrator outputs rather than past samples, so the filter stays
+    well behaved while g and k move and keeps its precision for low cutoffs at high
+    sample rates. Routing works as in BiquadBank: lanes a section doesn't filter get the
+    identity mix m0 = 1, m1 = m2 = 0.
+
+    setSection() sets a target; the next process() call glides the section to it with a
+    linear ramp of g, k and the mix across the block, retuning every sample. Sections
+    that just became active, and everything after jumpToTargets(), start on their
+    target instead.
+*/
+template <typename SampleType, size_t MaxSections>
+class SvfBank
+{
+public:
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t numLanes = SIMDType::SIMDNumElements;
+    static constexpr size_t maxGroupSize = 4;
+
+    SvfBank()
+    {
+        packedIndex.fill(-1);
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels <= numLanes);
+
+        buffer.allocate(spec.maximumBlockSize);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        ic1.fill(SIMDType::expand(0));
+        ic2.fill(SIMDType::expand(0));
+    }
+
+    // Takes g, k, m0, m1, m2. A new routing takes effect without a glide.
+    template <typename CoefficientType>
+    void setSection(size_t index, const std::array<CoefficientType, 5>& values, bool shouldBeBypassed = false,
+                    ChannelRouting routing = ChannelRouting::stereo) noexcept
+    {
+        jassert(index < MaxSections);
+
+        Section section { static_cast<SampleType>(values[0]),
+                          static_cast<SampleType>(values[1]),
+                          static_cast<SampleType>(values[2]),
+                          static_cast<SampleType>(values[3]),
+                          static_cast<SampleType>(values[4]),
+                          shouldBeBypassed,
+                          routing };
+
+        auto& target = targets[index];
+        if (section.bypassed != target.bypassed || section.isActive() != target.isActive()
+            || section.routing != target.routing)
+            layoutChanged = true;
+        if (! section.hasSameTuning(target))
+            ramping = true;
+
+        target = section;
+        targetsChanged = true;
+    }
+
+    void jumpToTargets() noexcept
+    {
+        currents = targets;
+        layoutChanged = true;
+        ramping = false;
+    }
+
+    bool isRamping() const noexcept
+    {
+        return ramping;
+    }
+
+    size_t getNumActiveSections() const noexcept
+    {
+        return numActive;
+    }
+
+    // The context may hold another sample type than the bank; see InterleavedBuffer.
+    template <typename IOType>
+    void process(const juce::dsp::ProcessContextReplacing<IOType>& context) noexcept
+    {
+        if (layoutChanged)
+            updateLayout();
+        else if (targetsChanged)
+            packTargets();
+
+        if (context.isBypassed || numActive == 0)
+        {
+            finishRamp();
+            return;
+        }
+
+        auto& block = context.getOutputBlock();
+        auto numSamples = block.getNumSamples();
+
+        buffer.interleave(block, runs.isMidSide(0));
+
+        for (size_t run = 0, first = 0; run < runs.size(); first = runs.getEnd(run++))
+        {
+            if (run > 0)
+                buffer.convertMidSide(numSamples, runs.isMidSide(run));
+
+            for (; first < runs.getEnd(run); first += maxGroupSize)
+            {
+                auto groupSize = juce::jmin(maxGroupSize, runs.getEnd(run) - first);
+
+                if (ramping)
+                {
+                    switch (groupSize)
+                    {
+                        case 4:  processGroup<4, true>(first, numSamples); break;
+                        case 3:  processGroup<3, true>(first, numSamples); break;
+                        case 2:  processGroup<2, true>(first, numSamples); break;
+                        default: processGroup<1, true>(first, numSamples); break;
+                    }
+                }
+                else
+                {
+                    switch (groupSize)
+                    {
+                        case 4:  processGroup<4, false>(first, numSamples); break;
+                        case 3:  processGroup<3, false>(first, numSamples); break;
+                        case 2:  processGroup<2, false>(first, numSamples); break;
+                        default: processGroup<1, false>(first, numSamples); break;
+                    }
+                }
+            }
+        }
+
+        buffer.deinterleave(block, runs.isMidSide(runs.size() - 1));
+        finishRamp();
+    }
+
+private:
+    struct Section
+    {
+        SampleType g, k, m0, m1, m2;
+        bool bypassed;
+        ChannelRouting routing;
+
+        bool isActive() const noexcept
+        {
+            return ! bypassed && ! (m0 == SampleType(1) && m1 == SampleType() && m2 == SampleType());
+        }
+
+        bool hasSameTuning(const Section& other) const noexcept
+        {
+            return g == other.g && k == other.k && m0 == other.m0 && m1 == other.m1 && m2 == other.m2;
+        }
+    };
+
+    // Every section as last set and as currently running, indexed by cascade position.
+    std::array<Section, MaxSections> targets {}, currents {};
+    std::array<int, MaxSections> packedIndex;
+    bool layoutChanged = true, targetsChanged = false, ramping = false;
+
+    // The sections that are active at either end of the ramp, packed in cascade order,
+    // with per-lane mixes.
+    size_t numActive = 0;
+    std::array<size_t, MaxSections> packedSource {};
+    std::array<SampleType, MaxSections> g {}, k {}, targetG {}, targetK {};
+    std::array<SIMDType, MaxSections> m0, m1, m2, targetM0, targetM1, targetM2;
+    std::array<SIMDType, MaxSections> ic1, ic2;
+    RoutingRuns<MaxSections> runs;
+
+    InterleavedBuffer<SampleType> buffer;
+
+    void updateLayout() noexcept
+    {
+        std::array<SIMDType, MaxSections> newIc1, newIc2;
+        numActive = 0;
+        runs.clear();
+
+        for (size_t index = 0; index < MaxSections; ++index)
+        {
+            // State built for other lanes or another representation starts again.
+            auto previous = currents[index].routing == targets[index].routing ? packedIndex[index] : -1;
+
+            if (! currents[index].isActive() && ! targets[index].isActive())
+            {
+                packedIndex[index] = -1;
+                continue;
+            }
+
+            // A section joining the cascade has no state to glide with.
+            if (previous < 0)
+                currents[index] = targets[index];
+
+            const auto& current = currents[index];
+            auto p = numActive++;
+            packedSource[p] = index;
+            g[p] = current.g;
+            k[p] = current.k;
+            m0[p] = InterleavedBuffer<SampleType>::routeLanes(current.m0, SampleType(1), current.routing);
+            m1[p] = InterleavedBuffer<SampleType>::routeLanes(current.m1, SampleType(), current.routing);
+            m2[p] = InterleavedBuffer<SampleType>::routeLanes(current.m2, SampleType(), current.routing);
+            runs.add(current.routing);
+            newIc1[p] = previous >= 0 ? ic1[(size_t) previous] : SIMDType::expand(0);
+            newIc2[p] = previous >= 0 ? ic2[(size_t) previous] : SIMDType::expand(0);
+            packedIndex[index] = (int) p;
+        }
+
+        ic1 = newIc1;
+        ic2 = newIc2;
+        layoutChanged = false;
+        packTargets();
+    }
+
+    void packTargets() noexcept
+    {
+        for (size_t p = 0; p < numActive; ++p)
+        {
+            const auto& target = targets[packedSource[p]];
+            targetG[p] = target.g;
+            targetK[p] = target.k;
+            targetM0[p] = InterleavedBuffer<SampleType>::routeLanes(target.m0, SampleType(1), target.routing);
+            targetM1[p] = InterleavedBuffer<SampleType>::routeLanes(target.m1, SampleType(), target.routing);
+            targetM2[p] = InterleavedBuffer<SampleType>::routeLanes(target.m2, SampleType(), target.routing);
+        }
+
+        targetsChanged = false;
+    }
+
+    void finishRamp() noexcept
+    {
+        if (! ramping)
+            return;
+
+        for (size_t p = 0; p < numActive; ++p)
+        {
+            g[p] = targetG[p];
+            k[p] = targetK[p];
+            m0[p] = targetM0[p];
+            m1[p] = targetM1[p];
+            m2[p] = targetM2[p];
+        }
+
+        // Sections that ramped to identity or bypass drop out on the next block.
+        for (size_t index = 0; index < MaxSections; ++index)
+            if (currents[index].isActive() != targets[index].isActive())
+                layoutChanged = true;
+
+        currents = targets;
+        ramping = false;
+    }
+
+    template <size_t NumStages, bool Ramping>
+    void processGroup(size_t first, size_t numSamples) noexcept
+    {
+        SampleType cg[NumStages], ck[NumStages], dg[NumStages], dk[NumStages];
+        SIMDType cm0[NumStages], cm1[NumStages], cm2[NumStages], dm0[NumStages], dm1[NumStages], dm2[NumStages];
+        SampleType ca1[NumStages], ca2[NumStages], ca3[NumStages];
+        SIMDType lic1[NumStages], lic2[NumStages];
+
+        auto rampScale = numSamples > 0 ? SampleType(1) / static_cast<SampleType>(numSamples) : SampleType();
+
+        for (size_t stage = 0; stage < NumStages; ++stage)
+        {
+            auto p = first + stage;
+            cg[stage] = g[p];
+            ck[stage] = k[p];
+            cm0[stage] = m0[p];
+            cm1[stage] = m1[p];
+            cm2[stage] = m2[p];
+            dg[stage] = (targetG[p] - g[p]) * rampScale;
+            dk[stage] = (targetK[p] - k[p]) * rampScale;
+            dm0[stage] = (targetM0[p] - m0[p]) * rampScale;
+            dm1[stage] = (targetM1[p] - m1[p]) * rampScale;
+            dm2[stage] = (targetM2[p] - m2[p]) * rampScale;
+            lic1[stage] = ic1[p];
+            lic2[stage] = ic2[p];
+
+            ca1[stage] = SampleType(1) / (SampleType(1) + cg[stage] * (cg[stage] + ck[stage]));
+            ca2[stage] = cg[stage] * ca1[stage];
+            ca3[stage] = cg[stage] * ca2[stage];
+        }
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto* frame = buffer.getFrame(i);
+            auto input = SIMDType::fromRawArray(frame);
+
+            for (size_t stage = 0; stage < NumStages; ++stage)
+            {
+                if (Ramping)
+                {
+                    cg[stage] += dg[stage];
+                    ck[stage] += dk[stage];
+                    cm0[stage] += dm0[stage];
+                    cm1[stage] += dm1[stage];
+                    cm2[stage] += dm2[stage];
+
+                    ca1[stage] = SampleType(1) / (SampleType(1) + cg[stage] * (cg[stage] + ck[stage]));
+                    ca2[stage] = cg[stage] * ca1[stage];
+                    ca3[stage] = cg[stage] * ca2[stage];
+                }
+
+                auto v3 = input - lic2[stage];
+                auto v1 = (lic1[stage] * ca1[stage]) + (v3 * ca2[stage]);
+                auto v2 = lic2[stage] + (lic1[stage] * ca2[stage]) + (v3 * ca3[stage]);
+                lic1[stage] = (v1 * SampleType(2)) - lic1[stage];
+                lic2[stage] = (v2 * SampleType(2)) - lic2[stage];
+                input = (input * cm0[stage]) + (v1 * cm1[stage]) + (v2 * cm2[stage]);
+            }
+
+            input.copyToRawArray(frame);
+        }
+
+        for (size_t stage = 0; stage < NumStages; ++stage)
+        {
+            ic1[first + stage] = InterleavedBuffer<SampleType>::snapToZero(lic1[stage]);
+            ic2[first + stage] = InterleavedBuffer<SampleType>::snapToZero(lic2[stage]);
+        }
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Wait-free handoff of a whole value from one producer thread to one consumer thread.
+
+    The producer fills getWriteBuffer() and calls publish(); the consumer calls update()
+    and reads getReadBuffer(). Each side swaps its private slot with the shared middle
+    slot through a single atomic exchange, so neither ever waits for the other and the
+    consumer always sees a complete value, never a mix of two publishes.
+*/
+template <typename ValueType>
+class TripleBuffer
+{
+public:
+    ValueType& getWriteBuffer() noexcept
+    {
+        return buffers[(size_t) writeIndex];
+    }
+
+    void publish() noexcept
+    {
+        auto previous = middle.exchange(writeIndex | freshFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // Returns true if a newer value was published since the last call.
+    bool update() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const ValueType& getReadBuffer() const noexcept
+    {
+        return buffers[(size_t) readIndex];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<ValueType, 3> buffers;
+    int writeIndex = 0, readIndex = 1;
+    std::atomic<int> middle { 2 };
+};